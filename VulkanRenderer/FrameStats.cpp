@@ -0,0 +1,220 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <iostream>
+
+/// <summary>
+/// Adds a frame's timings to the rolling window and emits
+/// any configured console/CSV output
+/// </summary>
+/// <param name="sample"></param>
+void FrameStats::recordFrame(const FrameSample& sample)
+{
+	if (mSamples.size() < mWindowCapacity)
+	{
+		mSamples.push_back(sample);
+	} else
+	{
+		mSamples[mNextSample] = sample;
+		mNextSample = (mNextSample + 1) % mWindowCapacity;
+	}
+
+	mLastFrame = sample;
+	mFrameCount++;
+
+	if (mCsvFile.is_open())
+	{
+		mCsvFile << sample.frameMs << ',' << sample.acquireMs << ','
+			<< sample.recordMs << ',' << sample.submitMs << ','
+			<< sample.presentMs << ',' << sample.gpuMs << ','
+			<< sample.pacingWaitMs << ','
+			<< sample.inputVertices << ',' << sample.inputPrimitives << ','
+			<< sample.vertexInvocations << ',' << sample.clippedPrimitives << ','
+			<< sample.fragmentInvocations << ',' << sample.samplesPassed << '\n';
+	}
+
+	if (mReportInterval > 0 && mFrameCount % mReportInterval == 0)
+	{
+		report();
+	}
+}
+
+/// <summary>
+/// Drops every recorded sample and resizes the rolling window, so a
+/// measurement phase can start from a clean slate after warmup
+/// </summary>
+/// <param name="windowCapacity"></param>
+void FrameStats::reset(size_t windowCapacity)
+{
+	mSamples.clear();
+	mNextSample = 0;
+	mLastFrame = {};
+	mFrameCount = 0;
+	mWindowCapacity = std::max<size_t>(1, windowCapacity);
+}
+
+/// <summary>
+/// Returns the requested percentile of total frame time
+/// over the rolling window
+/// </summary>
+/// <param name="p"></param>
+/// <returns></returns>
+double FrameStats::percentile(double p) const
+{
+	if (mSamples.empty())
+	{
+		return 0.0;
+	}
+
+	std::vector<double> frameTimes;
+	frameTimes.reserve(mSamples.size());
+	for (const auto& sample: mSamples)
+	{
+		frameTimes.push_back(sample.frameMs);
+	}
+
+	size_t rank = (size_t)((p / 100.0) * (double)(frameTimes.size() - 1));
+	std::nth_element(frameTimes.begin(), frameTimes.begin() + (long)rank, frameTimes.end());
+	return frameTimes[rank];
+}
+
+double FrameStats::averageFrameMs() const
+{
+	if (mSamples.empty())
+	{
+		return 0.0;
+	}
+
+	double total = 0.0;
+	for (const auto& sample: mSamples)
+	{
+		total += sample.frameMs;
+	}
+	return total / (double)mSamples.size();
+}
+
+double FrameStats::averageGpuMs() const
+{
+	if (mSamples.empty())
+	{
+		return 0.0;
+	}
+
+	double total = 0.0;
+	for (const auto& sample: mSamples)
+	{
+		total += sample.gpuMs;
+	}
+	return total / (double)mSamples.size();
+}
+
+double FrameStats::averagePacingMs() const
+{
+	if (mSamples.empty())
+	{
+		return 0.0;
+	}
+
+	double total = 0.0;
+	for (const auto& sample: mSamples)
+	{
+		total += sample.pacingWaitMs;
+	}
+	return total / (double)mSamples.size();
+}
+
+double FrameStats::averagePrimitives() const
+{
+	if (mSamples.empty())
+	{
+		return 0.0;
+	}
+
+	double total = 0.0;
+	for (const auto& sample: mSamples)
+	{
+		total += (double)sample.inputPrimitives;
+	}
+	return total / (double)mSamples.size();
+}
+
+double FrameStats::averageFragmentInvocations() const
+{
+	if (mSamples.empty())
+	{
+		return 0.0;
+	}
+
+	double total = 0.0;
+	for (const auto& sample: mSamples)
+	{
+		total += (double)sample.fragmentInvocations;
+	}
+	return total / (double)mSamples.size();
+}
+
+const FrameSample& FrameStats::lastFrame() const
+{
+	return mLastFrame;
+}
+
+uint64_t FrameStats::frameCount() const
+{
+	return mFrameCount;
+}
+
+void FrameStats::setReportInterval(uint64_t interval)
+{
+	mReportInterval = interval;
+}
+
+/// <summary>
+/// Opens the CSV output file and writes the column header
+/// </summary>
+/// <param name="path"></param>
+void FrameStats::enableCsvOutput(const std::string& path)
+{
+	if (path.empty())
+	{
+		mCsvFile.close();
+		return;
+	}
+
+	mCsvFile.open(path, std::ios::trunc);
+	if (mCsvFile.is_open())
+	{
+		mCsvFile << "frameMs,acquireMs,recordMs,submitMs,presentMs,gpuMs,"
+			"pacingWaitMs,"
+			"inputVertices,inputPrimitives,vertexInvocations,"
+			"clippedPrimitives,fragmentInvocations,samplesPassed\n";
+	}
+}
+
+/// <summary>
+/// Prints the rolling percentile summary to the console
+/// </summary>
+void FrameStats::report() const
+{
+	std::cout << "Frame " << mFrameCount
+		<< " | avg " << averageFrameMs() << "ms"
+		<< " | p50 " << percentile(50.0) << "ms"
+		<< " | p95 " << percentile(95.0) << "ms"
+		<< " | p99 " << percentile(99.0) << "ms"
+		<< " | gpu " << averageGpuMs() << "ms";
+
+	//The wait stays zero when no target FPS is set
+	if (mLastFrame.pacingWaitMs > 0.0)
+	{
+		std::cout << " | pace " << averagePacingMs() << "ms";
+	}
+
+	//The counters stay zero when the query mode is off
+	if (mLastFrame.inputPrimitives > 0)
+	{
+		std::cout << " | prims " << averagePrimitives()
+			<< " | frags " << averageFragmentInvocations()
+			<< " | visible " << mLastFrame.samplesPassed;
+	}
+
+	std::cout << std::endl;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+
+//How many frames the rolling statistics window holds by default;
+//reset() can resize it (the benchmark sizes it to a whole run)
+constexpr size_t FRAME_STATS_WINDOW = 240;
+
+/// <summary>
+/// Per-frame timing sample covering each stage of drawFrame
+/// plus the GPU time measured by timestamp queries
+/// </summary>
+struct FrameSample
+{
+	double frameMs{};
+	double acquireMs{};
+	double recordMs{};
+	double submitMs{};
+	double presentMs{};
+	double gpuMs{};
+
+	//Time the pacing governor spent waiting before this frame
+	//(zero when no target FPS is set)
+	double pacingWaitMs{};
+
+	//GPU pipeline-statistics and occlusion counters for the frame
+	//(zero when the counter query mode is off or unsupported)
+	uint64_t inputVertices{};
+	uint64_t inputPrimitives{};
+	uint64_t vertexInvocations{};
+	uint64_t clippedPrimitives{};
+	uint64_t fragmentInvocations{};
+	uint64_t samplesPassed{};
+};
+
+/// <summary>
+/// Rolling frame-time statistics with percentile queries, periodic
+/// console reporting, and optional per-frame CSV output
+/// </summary>
+class FrameStats
+{
+public:
+	void recordFrame(const FrameSample& sample);
+
+	//Drops every recorded sample and resizes the rolling window, so a
+	//measurement phase can start clean after warmup
+	void reset(size_t windowCapacity = FRAME_STATS_WINDOW);
+
+	//Percentile over the rolling window of total frame times (p in [0, 100])
+	double percentile(double p) const;
+
+	double averageFrameMs() const;
+	double averageGpuMs() const;
+
+	//Average governor wait, showing how much frame time the target
+	//FPS hands back to the CPU
+	double averagePacingMs() const;
+
+	//Averages of the GPU counters over the rolling window; together
+	//they separate vertex-bound from fill-bound frames
+	double averagePrimitives() const;
+	double averageFragmentInvocations() const;
+	const FrameSample& lastFrame() const;
+	uint64_t frameCount() const;
+
+	//Print p50/p95/p99 to the console every interval frames (0 disables)
+	void setReportInterval(uint64_t interval);
+
+	//Stream every sample to a CSV file (empty path disables)
+	void enableCsvOutput(const std::string& path);
+
+private:
+	void report() const;
+
+	//Ring buffer of the last mWindowCapacity samples
+	std::vector<FrameSample> mSamples{};
+	size_t mNextSample{};
+	size_t mWindowCapacity = FRAME_STATS_WINDOW;
+
+	FrameSample mLastFrame{};
+	uint64_t mFrameCount{};
+
+	uint64_t mReportInterval{};
+	std::ofstream mCsvFile{};
+};
@@ -0,0 +1,241 @@
+#include "GpuAllocator.h"
+
+/// <summary>
+/// Caches the device handles and memory properties used by every allocation
+/// </summary>
+/// <param name="physicalDevice"></param>
+/// <param name="device"></param>
+void GpuAllocator::init(VkPhysicalDevice physicalDevice, VkDevice device)
+{
+	mDevice = device;
+
+	//Query memory properties once; findMemoryType reads the cached copy
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &mMemoryProperties);
+}
+
+/// <summary>
+/// Releases every slab back to the driver
+/// </summary>
+void GpuAllocator::destroy()
+{
+	for (auto& block : mBlocks)
+	{
+		vkFreeMemory(mDevice, block.memory, nullptr);
+	}
+	mBlocks.clear();
+}
+
+/// <summary>
+/// Finds (or creates) a slab of the right memory type and carves an
+/// aligned sub-range out of its free list
+/// </summary>
+/// <param name="requirements"></param>
+/// <param name="properties"></param>
+/// <returns></returns>
+GpuAllocation GpuAllocator::allocate(const VkMemoryRequirements& requirements,
+	VkMemoryPropertyFlags properties)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+
+	//First-fit search across existing blocks of the right memory type
+	for (uint32_t blockIndex = 0; blockIndex < (uint32_t)mBlocks.size(); blockIndex++)
+	{
+		MemoryBlock& block = mBlocks[blockIndex];
+
+		if (block.memoryTypeIndex != memoryTypeIndex)
+		{
+			continue;
+		}
+
+		for (size_t rangeIndex = 0; rangeIndex < block.freeRanges.size(); rangeIndex++)
+		{
+			FreeRange& range = block.freeRanges[rangeIndex];
+
+			//Align the start of the range up to the resource's requirement
+			VkDeviceSize alignedOffset = (range.offset + requirements.alignment - 1)
+				& ~(requirements.alignment - 1);
+			VkDeviceSize padding = alignedOffset - range.offset;
+
+			if (range.size < padding + requirements.size)
+			{
+				continue;
+			}
+
+			GpuAllocation allocation{};
+			allocation.memory = block.memory;
+			allocation.offset = alignedOffset;
+			allocation.size = requirements.size;
+			allocation.blockIndex = blockIndex;
+
+			//Shrink the free range, keeping any alignment padding free
+			VkDeviceSize rangeEnd = range.offset + range.size;
+			VkDeviceSize allocationEnd = alignedOffset + requirements.size;
+
+			if (padding > 0)
+			{
+				range.size = padding;
+				if (allocationEnd < rangeEnd)
+				{
+					block.freeRanges.push_back({allocationEnd, rangeEnd - allocationEnd});
+				}
+			} else if (allocationEnd < rangeEnd)
+			{
+				range.offset = allocationEnd;
+				range.size = rangeEnd - allocationEnd;
+			} else
+			{
+				block.freeRanges.erase(block.freeRanges.begin() + (long)rangeIndex);
+			}
+
+			return allocation;
+		}
+	}
+
+	//No block had room; allocate a new slab
+	//(oversized resources get a dedicated slab)
+	VkDeviceSize blockSize = std::max(GPU_ALLOCATOR_BLOCK_SIZE, requirements.size);
+	uint32_t blockIndex = createBlock(memoryTypeIndex, blockSize);
+
+	MemoryBlock& block = mBlocks[blockIndex];
+
+	GpuAllocation allocation{};
+	allocation.memory = block.memory;
+	allocation.offset = 0;
+	allocation.size = requirements.size;
+	allocation.blockIndex = blockIndex;
+
+	//A fresh slab starts with one free range covering everything
+	FreeRange& range = block.freeRanges[0];
+	if (requirements.size < range.size)
+	{
+		range.offset = requirements.size;
+		range.size -= requirements.size;
+	} else
+	{
+		block.freeRanges.clear();
+	}
+
+	return allocation;
+}
+
+/// <summary>
+/// Returns a sub-range to its slab's free list, merging with neighbors
+/// </summary>
+/// <param name="allocation"></param>
+void GpuAllocator::free(const GpuAllocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (!allocation.isValid() || allocation.blockIndex >= mBlocks.size())
+	{
+		return;
+	}
+
+	MemoryBlock& block = mBlocks[allocation.blockIndex];
+
+	FreeRange freed{allocation.offset, allocation.size};
+
+	//Merge with any adjacent free ranges to fight fragmentation
+	for (size_t i = 0; i < block.freeRanges.size();)
+	{
+		FreeRange& range = block.freeRanges[i];
+
+		if (range.offset + range.size == freed.offset)
+		{
+			freed.offset = range.offset;
+			freed.size += range.size;
+			block.freeRanges.erase(block.freeRanges.begin() + (long)i);
+		} else if (freed.offset + freed.size == range.offset)
+		{
+			freed.size += range.size;
+			block.freeRanges.erase(block.freeRanges.begin() + (long)i);
+		} else
+		{
+			i++;
+		}
+	}
+
+	block.freeRanges.push_back(freed);
+}
+
+/// <summary>
+/// Maps an allocation's slab (once, persistently) and returns a
+/// pointer offset to the allocation's start
+/// </summary>
+/// <param name="allocation"></param>
+/// <returns></returns>
+void* GpuAllocator::map(const GpuAllocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (!allocation.isValid() || allocation.blockIndex >= mBlocks.size())
+	{
+		throw std::runtime_error("ERROR: Tried to map an invalid allocation!\n");
+	}
+
+	MemoryBlock& block = mBlocks[allocation.blockIndex];
+
+	//Map the whole slab the first time anyone asks; it stays mapped
+	//so per-frame writes never pay for vkMapMemory
+	if (block.mapped == nullptr)
+	{
+		if (vkMapMemory(mDevice, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped) != VK_SUCCESS)
+		{
+			throw std::runtime_error("ERROR: Failed to map memory block!\n");
+		}
+	}
+
+	return (char*)block.mapped + allocation.offset;
+}
+
+/// <summary>
+/// Finds a memory type matching the filter and property flags
+/// using the properties cached at init
+/// </summary>
+/// <param name="typeFilter"></param>
+/// <param name="properties"></param>
+/// <returns></returns>
+uint32_t GpuAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+{
+	for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; i++)
+	{
+		//Check if a bit at index is set to 1
+		if (typeFilter & (1 << i) &&
+			(mMemoryProperties.memoryTypes[i].propertyFlags & properties) ==
+			properties)
+		{
+			return i;
+		}
+	}
+
+	throw std::runtime_error("ERROR: Failed to find suitable memory type!\n");
+}
+
+/// <summary>
+/// Allocates a new VkDeviceMemory slab of the given memory type
+/// </summary>
+/// <param name="memoryTypeIndex"></param>
+/// <param name="size"></param>
+/// <returns></returns>
+uint32_t GpuAllocator::createBlock(uint32_t memoryTypeIndex, VkDeviceSize size)
+{
+	VkMemoryAllocateInfo allocationInfo{};
+	allocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocationInfo.allocationSize = size;
+	allocationInfo.memoryTypeIndex = memoryTypeIndex;
+
+	MemoryBlock block{};
+	block.size = size;
+	block.memoryTypeIndex = memoryTypeIndex;
+	block.freeRanges.push_back({0, size});
+
+	if (vkAllocateMemory(mDevice, &allocationInfo, nullptr, &block.memory) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to allocate memory block!\n");
+	}
+
+	mBlocks.push_back(block);
+	return (uint32_t)mBlocks.size() - 1;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+
+//Size of each VkDeviceMemory slab we carve sub-allocations out of (64 MB)
+constexpr VkDeviceSize GPU_ALLOCATOR_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+/// <summary>
+/// A sub-allocation handed out by the GpuAllocator
+/// </summary>
+struct GpuAllocation
+{
+	VkDeviceMemory memory{};
+	VkDeviceSize offset{};
+	VkDeviceSize size{};
+	uint32_t blockIndex{};
+
+	bool isValid() const
+	{
+		return memory != VK_NULL_HANDLE;
+	}
+};
+
+/// <summary>
+/// Sub-allocates buffer and image memory out of large VkDeviceMemory slabs
+/// so we stay far below the driver's total allocation cap and avoid paying
+/// for a vkAllocateMemory call per resource
+/// </summary>
+class GpuAllocator
+{
+public:
+	void init(VkPhysicalDevice physicalDevice, VkDevice device);
+	void destroy();
+
+	GpuAllocation allocate(const VkMemoryRequirements& requirements,
+		VkMemoryPropertyFlags properties);
+	void free(const GpuAllocation& allocation);
+
+	//Returns a persistent CPU pointer to a host-visible allocation;
+	//each slab is mapped once and stays mapped until destroy()
+	void* map(const GpuAllocation& allocation);
+
+	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+private:
+
+	/// <summary>
+	/// A contiguous unused range inside a block
+	/// </summary>
+	struct FreeRange
+	{
+		VkDeviceSize offset{};
+		VkDeviceSize size{};
+	};
+
+	/// <summary>
+	/// One VkDeviceMemory slab and its free list
+	/// </summary>
+	struct MemoryBlock
+	{
+		VkDeviceMemory memory{};
+		VkDeviceSize size{};
+		uint32_t memoryTypeIndex{};
+		std::vector<FreeRange> freeRanges{};
+
+		//Persistent mapping, created lazily on first map()
+		void* mapped{};
+	};
+
+	uint32_t createBlock(uint32_t memoryTypeIndex, VkDeviceSize size);
+
+	VkDevice mDevice{};
+
+	//Queried once at init instead of per allocation
+	VkPhysicalDeviceMemoryProperties mMemoryProperties{};
+
+	std::vector<MemoryBlock> mBlocks{};
+
+	//allocate/free/map are hit from the parallel init tasks
+	std::mutex mMutex{};
+};
@@ -0,0 +1,129 @@
+#include "ShaderManager.h"
+
+#include <stdexcept>
+#include <fstream>
+
+void ShaderManager::init(VkDevice device)
+{
+	mDevice = device;
+}
+
+/// <summary>
+/// Destroys every cached shader module
+/// </summary>
+void ShaderManager::destroy()
+{
+	for (auto& entry: mModules)
+	{
+		vkDestroyShaderModule(mDevice, entry.second, nullptr);
+	}
+
+	mModules.clear();
+	mPathToHash.clear();
+}
+
+/// <summary>
+/// Returns the module for a SPIR-V file; the file is read and the
+/// module created at most once, and files with identical contents
+/// share one module
+/// </summary>
+/// <param name="path"></param>
+/// <returns></returns>
+VkShaderModule ShaderManager::getModule(const std::string& path)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		auto hashEntry = mPathToHash.find(path);
+		if (hashEntry != mPathToHash.end())
+		{
+			return mModules[hashEntry->second];
+		}
+	}
+
+	//Read and hash outside the lock so a slow disk doesn't serialize
+	//the pipeline-compile workers
+	std::vector<char> code = readSpirvFile(path);
+	uint64_t hash = hashContents(code);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	//Another worker may have created the same module meanwhile
+	auto moduleEntry = mModules.find(hash);
+	if (moduleEntry != mModules.end())
+	{
+		mPathToHash[path] = hash;
+		return moduleEntry->second;
+	}
+
+	VkShaderModuleCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = code.size();
+	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(mDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create shader module!\n");
+	}
+
+	mPathToHash[path] = hash;
+	mModules[hash] = shaderModule;
+
+	return shaderModule;
+}
+
+/// <summary>
+/// Loads a batch of shaders up front so first use is never a miss
+/// </summary>
+/// <param name="paths"></param>
+void ShaderManager::preload(const std::vector<std::string>& paths)
+{
+	for (const auto& path: paths)
+	{
+		getModule(path);
+	}
+}
+
+/// <summary>
+/// Slurps a SPIR-V binary into memory
+/// </summary>
+/// <param name="path"></param>
+/// <returns></returns>
+std::vector<char> ShaderManager::readSpirvFile(const std::string& path) const
+{
+	//Open at the end to size the buffer in one go
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("ERROR: Failed to open shader file " + path + "!\n");
+	}
+
+	size_t fileSize = (size_t)file.tellg();
+	std::vector<char> buffer(fileSize);
+
+	file.seekg(0);
+	file.read(buffer.data(), (long)fileSize);
+
+	return buffer;
+}
+
+/// <summary>
+/// FNV-1a over the shader bytes; cheap and collision-safe enough
+/// for a per-process cache key
+/// </summary>
+/// <param name="code"></param>
+/// <returns></returns>
+uint64_t ShaderManager::hashContents(const std::vector<char>& code)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for (char byte: code)
+	{
+		hash ^= (uint8_t)byte;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+/// <summary>
+/// Loads SPIR-V files once and hands out shared VkShaderModules,
+/// keyed by a hash of the file contents so identical shaders map to
+/// one module and pipeline rebuilds never touch the disk again
+/// </summary>
+class ShaderManager
+{
+public:
+	void init(VkDevice device);
+	void destroy();
+
+	//Returns the module for a SPIR-V file, loading and creating it
+	//on first use; safe to call from worker threads
+	VkShaderModule getModule(const std::string& path);
+
+	//Loads a batch of shaders up front so first use is never a miss
+	void preload(const std::vector<std::string>& paths);
+
+private:
+	std::vector<char> readSpirvFile(const std::string& path) const;
+	static uint64_t hashContents(const std::vector<char>& code);
+
+	VkDevice mDevice{};
+
+	//Path -> content hash, so an unchanged file skips rehashing
+	std::map<std::string, uint64_t> mPathToHash{};
+
+	//Content hash -> module, shared by every path with the same bytes
+	std::map<uint64_t, VkShaderModule> mModules{};
+
+	//getModule is called from pipeline-compile workers
+	std::mutex mMutex{};
+};
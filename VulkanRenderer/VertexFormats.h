@@ -0,0 +1,172 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+/// <summary>
+/// Describes one vertex attribute of a stream at compile time
+/// </summary>
+template<uint32_t Location, VkFormat Format, uint32_t Offset>
+struct VertexAttribute
+{
+	static constexpr uint32_t LOCATION = Location;
+	static constexpr VkFormat FORMAT = Format;
+	static constexpr uint32_t OFFSET = Offset;
+};
+
+/// <summary>
+/// One binding stream and the attributes fetched from it
+/// </summary>
+template<uint32_t Binding, uint32_t Stride, typename... Attributes>
+struct VertexStream
+{
+	static constexpr uint32_t ATTRIBUTE_COUNT = sizeof...(Attributes);
+
+	static constexpr VkVertexInputBindingDescription getBindingDescription()
+	{
+		VkVertexInputBindingDescription bindingDescription{};
+		bindingDescription.binding = Binding;
+		bindingDescription.stride = Stride;
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescription;
+	}
+
+	static constexpr std::array<VkVertexInputAttributeDescription, ATTRIBUTE_COUNT>
+	getAttributeDescriptions()
+	{
+		return {makeAttribute<Attributes>()...};
+	}
+
+private:
+	template<typename Attribute>
+	static constexpr VkVertexInputAttributeDescription makeAttribute()
+	{
+		VkVertexInputAttributeDescription description{};
+		description.binding = Binding;
+		description.location = Attribute::LOCATION;
+		description.format = Attribute::FORMAT;
+		description.offset = Attribute::OFFSET;
+		return description;
+	}
+};
+
+/// <summary>
+/// A full vertex layout built from binding streams; the description
+/// arrays are generated at compile time from the same template
+/// arguments, so a new format can't drift from what the pipeline
+/// declares without failing to compile
+/// </summary>
+template<typename... Streams>
+struct VertexLayout
+{
+	static constexpr uint32_t STREAM_COUNT = sizeof...(Streams);
+	static constexpr uint32_t ATTRIBUTE_COUNT = (Streams::ATTRIBUTE_COUNT + ...);
+
+	static constexpr std::array<VkVertexInputBindingDescription, STREAM_COUNT>
+	getBindingDescriptions()
+	{
+		return {Streams::getBindingDescription()...};
+	}
+
+	static constexpr std::array<VkVertexInputAttributeDescription, ATTRIBUTE_COUNT>
+	getAttributeDescriptions()
+	{
+		std::array<VkVertexInputAttributeDescription, ATTRIBUTE_COUNT> descriptions{};
+		size_t next = 0;
+
+		(appendStream<Streams>(descriptions, next), ...);
+
+		return descriptions;
+	}
+
+private:
+	template<typename Stream>
+	static constexpr void appendStream(
+		std::array<VkVertexInputAttributeDescription, ATTRIBUTE_COUNT>& descriptions,
+		size_t& next)
+	{
+		for (const auto& attribute: Stream::getAttributeDescriptions())
+		{
+			descriptions[next++] = attribute;
+		}
+	}
+};
+
+#pragma region Quantization helpers
+
+inline int16_t packSnorm16(float value)
+{
+	return (int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+inline uint8_t packUnorm8(float value)
+{
+	return (uint8_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+}
+
+inline uint16_t packUnorm16(float value)
+{
+	return (uint16_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f);
+}
+#pragma endregion
+
+/// <summary>
+/// Stream 0: position alone, so depth-only passes fetch 4 bytes per
+/// vertex and nothing else; SNORM16 covers clip space [-1, 1]
+/// </summary>
+struct PackedPosition
+{
+	int16_t x{};
+	int16_t y{};
+};
+
+/// <summary>
+/// Stream 1: quantized shading attributes, fetched only by passes
+/// that actually shade
+/// </summary>
+struct PackedShadingAttributes
+{
+	uint8_t color[4]{};
+	uint16_t u{};
+	uint16_t v{};
+};
+
+inline PackedPosition packPosition(const glm::vec2& position)
+{
+	PackedPosition packed{};
+	packed.x = packSnorm16(position.x);
+	packed.y = packSnorm16(position.y);
+	return packed;
+}
+
+inline PackedShadingAttributes packShadingAttributes(const glm::vec3& color,
+	const glm::vec2& uv)
+{
+	PackedShadingAttributes packed{};
+	packed.color[0] = packUnorm8(color.r);
+	packed.color[1] = packUnorm8(color.g);
+	packed.color[2] = packUnorm8(color.b);
+	packed.color[3] = 255;
+	packed.u = packUnorm16(uv.x);
+	packed.v = packUnorm16(uv.y);
+	return packed;
+}
+
+//The layout every registered mesh is packed into: 12 bytes per
+//vertex across both streams instead of the 28-byte interleaved
+//struct, and the shader locations match shader.vert
+using MeshVertexLayout = VertexLayout<
+	VertexStream<0, sizeof(PackedPosition),
+		VertexAttribute<0, VK_FORMAT_R16G16_SNORM, 0>>,
+	VertexStream<1, sizeof(PackedShadingAttributes),
+		VertexAttribute<1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedShadingAttributes, color)>,
+		VertexAttribute<2, VK_FORMAT_R16G16_UNORM, offsetof(PackedShadingAttributes, u)>>>;
@@ -8,25 +8,176 @@ VulkanRenderer::~VulkanRenderer()
 }
 
 /// <summary>
-/// Initializes all GLFW and Vulkan components
+/// Initializes all GLFW and Vulkan components; everything after the
+/// swap chain runs as a dependency graph on the worker pool, so
+/// window-to-first-frame pays for the critical path instead of the
+/// serial sum of every creation step
 /// </summary>
 void VulkanRenderer::init()
 {
-	createWindow();
+	//Windowing, instance, and device bring-up stay sequential: GLFW
+	//is main-thread only and everything below needs the device
+	//(headless runs have no window or surface at all)
+	if (!mHeadless)
+	{
+		createWindow();
+	}
+
 	createInstance();
 	setupDebugMessenger();
-	createSurface();
+
+	if (!mHeadless)
+	{
+		createSurface();
+		createExtraWindows();
+	}
+
 	pickPhysicalDevice();
 	createLogicalDevice();
-	createSwapChain();
+	mAllocator.init(mPhysicalDevice, mDevice);
+	mShaderManager.init(mDevice);
+
+	//The swap chain asks GLFW for the framebuffer size, so it stays
+	//on the main thread too
+	if (mHeadless)
+	{
+		createHeadlessTargets();
+	} else
+	{
+		createSwapChain();
+	}
+
 	createImageViews();
-	createRenderPass();
-	createGraphicsPipeline();
-	createFramebuffers();
-	createCommandPool();
-	createVertexBuffer();
-	createCommandBuffers();
-	createSyncObjects();
+
+	tf::Taskflow taskflow;
+
+	//Batch-load the shaders we know about before any pipeline asks;
+	//this overlaps the disk reads with the GPU object creation below
+	auto shaders = taskflow.emplace([this]
+	{
+		mShaderManager.preload({"../shaders/vert.spv", "../shaders/frag.spv"});
+	});
+
+	//With dynamic rendering there is no render pass or framebuffer
+	//object at all; pipelines carry the attachment formats instead
+	auto renderPass = taskflow.emplace([this]
+	{
+		if (mDynamicRenderingActive)
+		{
+			mDepthFormat = findDepthFormat();
+		} else
+		{
+			createRenderPass();
+		}
+	});
+
+	auto descriptorLayout = taskflow.emplace([this]
+	{
+		createDescriptorSetLayout();
+	});
+
+	auto pipeline = taskflow.emplace([this]
+	{
+		createPipelineCache();
+		createGraphicsPipeline();
+	});
+
+	auto depth = taskflow.emplace([this]
+	{
+		createDepthResources();
+	});
+
+	auto framebuffers = taskflow.emplace([this]
+	{
+		if (!mDynamicRenderingActive)
+		{
+			createFramebuffers();
+		}
+	});
+
+	auto pools = taskflow.emplace([this]
+	{
+		createCommandPool();
+		createWorkerCommandPools();
+		createStreamingResources();
+	});
+
+	//The default quad upload and the procedural checkerboard both
+	//submit single-time commands on mCommandPool, so they share one
+	//task instead of racing on the pool
+	auto uploads = taskflow.emplace([this]
+	{
+		registerMesh(VERTICES, INDICES);
+		buildMeshBuffers();
+		createTextureSampler();
+		createDefaultTexture();
+	});
+
+	auto uniforms = taskflow.emplace([this]
+	{
+		createUniformBuffers();
+	});
+
+	auto descriptors = taskflow.emplace([this]
+	{
+		createDescriptorPool();
+		createDescriptorSets();
+	});
+
+	auto commandBuffers = taskflow.emplace([this]
+	{
+		createCommandBuffers();
+	});
+
+	auto queries = taskflow.emplace([this]
+	{
+		createTimestampQueryPool();
+		createGpuCounterQueryPools();
+	});
+
+	auto sync = taskflow.emplace([this]
+	{
+		createSyncObjects();
+	});
+
+	//Order only where a real dependency exists
+	pipeline.succeed(shaders, renderPass, descriptorLayout);
+	depth.succeed(renderPass);
+	framebuffers.succeed(renderPass, depth);
+	descriptors.succeed(descriptorLayout, uniforms, uploads);
+	commandBuffers.succeed(pools);
+
+	//registerMesh flags the command buffers dirty, so the dirty-flag
+	//vector has to exist before the upload task touches it
+	uploads.succeed(pools, commandBuffers);
+
+	//createTexture peeks at the in-flight fences, so the default
+	//texture upload must finish before they exist
+	sync.succeed(uploads);
+
+	mExecutor.run(taskflow).wait();
+
+	//Extra windows hang everything off the shared objects above, so
+	//they are built last (createSyncObjects settles mMaxFramesInFlight)
+	for (auto& windowSurface: mExtraWindows)
+	{
+		createExtraWindowSwapChain(windowSurface);
+	}
+
+	//Label the handles created above so captures aren't anonymous
+	nameCoreObjects();
+
+	//Summarize frame times once per rolling window
+	mFrameStats.setReportInterval(FRAME_STATS_WINDOW);
+}
+
+/// <summary>
+/// Exposes the frame-time statistics for configuration and queries
+/// </summary>
+/// <returns></returns>
+FrameStats& VulkanRenderer::getFrameStats()
+{
+	return mFrameStats;
 }
 
 /// <summary>
@@ -34,31 +185,133 @@ void VulkanRenderer::init()
 /// </summary>
 void VulkanRenderer::cleanup()
 {
-	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	for (uint32_t i = 0; i < mMaxFramesInFlight; i++)
 	{
 		vkDestroySemaphore(mDevice, mImageAvailableSemaphore[i], nullptr);
-		vkDestroySemaphore(mDevice, mRenderFinishedSemaphore[i], nullptr);
 		vkDestroyFence(mDevice, mInFlightFence[i], nullptr);
 	}
 
+	//Render-finished semaphores are per swap-chain image
+	for (auto semaphore: mRenderFinishedSemaphore)
+	{
+		vkDestroySemaphore(mDevice, semaphore, nullptr);
+	}
+
 	vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
 
+	for (auto workerPool : mWorkerCommandPools)
+	{
+		vkDestroyCommandPool(mDevice, workerPool, nullptr);
+	}
+
+	//The device is idle here, so anything still pending can go
+	destroyRetiredSwapChains(true);
+	destroyRetiredResources(true);
+
 	cleanupSwapChain();
 
-	vkDestroyBuffer(mDevice, mVertexBuffer, nullptr);
-	vkFreeMemory(mDevice, mVertexBufferMemory, nullptr);
+	//Extra windows: device-level objects now, surfaces and GLFW
+	//windows after the device goes away
+	for (auto& windowSurface: mExtraWindows)
+	{
+		for (auto semaphore: windowSurface.imageAvailableSemaphores)
+		{
+			vkDestroySemaphore(mDevice, semaphore, nullptr);
+		}
+
+		destroyExtraWindowSwapChain(windowSurface);
+	}
+
+	vkDestroyBuffer(mDevice, mPositionBuffer, nullptr);
+	mAllocator.free(mPositionBufferAllocation);
+
+	vkDestroyBuffer(mDevice, mAttributeBuffer, nullptr);
+	mAllocator.free(mAttributeBufferAllocation);
+
+	vkDestroyBuffer(mDevice, mIndexBuffer, nullptr);
+	mAllocator.free(mIndexBufferAllocation);
+
+	vkDestroyBuffer(mDevice, mIndirectBuffer, nullptr);
+	mAllocator.free(mIndirectBufferAllocation);
+
+	vkDestroyBuffer(mDevice, mStagingBuffer, nullptr);
+	mAllocator.free(mStagingBufferAllocation);
+
+	//Streaming ring; the device is idle so nothing is in flight
+	for (auto& slot: mStreamingSlots)
+	{
+		vkDestroyBuffer(mDevice, slot.stagingBuffer, nullptr);
+		mAllocator.free(slot.stagingAllocation);
+		vkDestroyFence(mDevice, slot.fence, nullptr);
+		vkDestroySemaphore(mDevice, slot.copyComplete, nullptr);
+	}
+
+	vkDestroyCommandPool(mDevice, mTransferCommandPool, nullptr);
+
+	//Compute objects only exist if setupCompute was called;
+	//destroying VK_NULL_HANDLE is a no-op
+	vkDestroySemaphore(mDevice, mComputeFinishedSemaphore, nullptr);
+	vkDestroyFence(mDevice, mComputeFence, nullptr);
+	vkDestroyCommandPool(mDevice, mComputeCommandPool, nullptr);
+	vkDestroyPipeline(mDevice, mComputePipeline, nullptr);
+	vkDestroyPipelineLayout(mDevice, mComputePipelineLayout, nullptr);
+	vkDestroyDescriptorPool(mDevice, mComputeDescriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(mDevice, mComputeDescriptorSetLayout, nullptr);
+	vkDestroyBuffer(mDevice, mComputeStorageBuffer, nullptr);
+	mAllocator.free(mComputeStorageBufferAllocation);
+
+	//Slab mappings stay alive until the allocator is destroyed
+	for (size_t i = 0; i < mUniformBuffers.size(); i++)
+	{
+		vkDestroyBuffer(mDevice, mUniformBuffers[i], nullptr);
+		mAllocator.free(mUniformBufferAllocations[i]);
+	}
+
+	destroyTexture();
+	vkDestroySampler(mDevice, mTextureSampler, nullptr);
 
-	vkDestroyBuffer(mDevice, mVertexBuffer, nullptr);
+	vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(mDevice, mDescriptorSetLayout, nullptr);
+
+	vkDestroyQueryPool(mDevice, mTimestampQueryPool, nullptr);
+	vkDestroyQueryPool(mDevice, mPipelineStatsQueryPool, nullptr);
+	vkDestroyQueryPool(mDevice, mOcclusionQueryPool, nullptr);
+
+	//Let in-flight variant compiles finish before tearing down
+	mExecutor.wait_for_all();
+
+	for (auto& variant: mPipelineVariants)
+	{
+		vkDestroyPipeline(mDevice, variant.second, nullptr);
+	}
 
 	vkDestroyPipeline(mDevice, mGraphicsPipeline, nullptr);
 
+	//Persist the pipeline cache so the next launch skips recompilation
+	savePipelineCache();
+	vkDestroyPipelineCache(mDevice, mPipelineCache, nullptr);
+
 	vkDestroyPipelineLayout(mDevice, mPipelineLayout, nullptr);
 
 	vkDestroyRenderPass(mDevice, mRenderPass, nullptr);
 
+	//No pipeline can need the cached shader modules anymore
+	mShaderManager.destroy();
+
+	//Release the memory slabs after every resource using them is gone
+	mAllocator.destroy();
+
 	vkDestroyDevice(mDevice, nullptr);
 
-	glfwDestroyWindow(mpWindow);
+	if (!mHeadless)
+	{
+		for (auto& windowSurface: mExtraWindows)
+		{
+			glfwDestroyWindow(windowSurface.window);
+		}
+
+		glfwDestroyWindow(mpWindow);
+	}
 
 	if (ENABLED_VALIDATION_LAYERS)
 	{
@@ -66,20 +319,75 @@ void VulkanRenderer::cleanup()
 		                              mDebugMessenger, nullptr);
 	}
 
+	for (auto& windowSurface: mExtraWindows)
+	{
+		vkDestroySurfaceKHR(mInstance, windowSurface.surface, nullptr);
+	}
+
 	vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
 
 	//Destroy instance last to prevent memory leaks
 	vkDestroyInstance(mInstance, nullptr);
 
-	glfwTerminate();
+	if (!mHeadless)
+	{
+		glfwTerminate();
+	}
 }
 
 void VulkanRenderer::update()
 {
+	if (mHeadless)
+	{
+		auto runStart = std::chrono::high_resolution_clock::now();
+
+		//Render flat out until a configured bound is hit; there is no
+		//present mode to cap the frame rate
+		while (true)
+		{
+			if (mHeadlessFrameLimit != 0 && mFrameNumber >= mHeadlessFrameLimit)
+			{
+				break;
+			}
+
+			if (mHeadlessDurationLimit > 0.0)
+			{
+				double elapsed = std::chrono::duration<double>(
+					std::chrono::high_resolution_clock::now() - runStart).count();
+
+				if (elapsed >= mHeadlessDurationLimit)
+				{
+					break;
+				}
+			}
+
+			//The governor applies headless too; thermally constrained
+			//soak runs want a predictable rate, not a flat-out one
+			paceFrame();
+			drawFrame();
+		}
+
+		vkDeviceWaitIdle(mDevice);
+		return;
+	}
+
 	//Main loop
 	while (!glfwWindowShouldClose(mpWindow))
 	{
-		glfwPollEvents();
+		//Wait out the frame budget first so the events polled just
+		//before drawFrame are as fresh as possible
+		paceFrame();
+
+		//With no focused window, idle in the event wait and render at
+		//the background rate instead of spinning flat out
+		if (mIdleWhenUnfocused && !anyWindowFocused())
+		{
+			glfwWaitEventsTimeout(mBackgroundFrameSeconds);
+		} else
+		{
+			glfwPollEvents();
+		}
+
 		drawFrame();
 	}
 
@@ -87,88 +395,417 @@ void VulkanRenderer::update()
 	vkDeviceWaitIdle(mDevice);
 }
 
+/// <summary>
+/// Waits out the remainder of the frame budget when a target FPS is
+/// set: a coarse OS sleep up to the slack margin, then a precise spin
+/// to the deadline. Deadlines chain off each other so sleep jitter
+/// never accumulates into drift
+/// </summary>
+void VulkanRenderer::paceFrame()
+{
+	mPacingWaitMs = 0.0;
+
+	if (mTargetFrameSeconds <= 0.0)
+	{
+		return;
+	}
+
+	auto waitStart = std::chrono::steady_clock::now();
+	auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(mTargetFrameSeconds));
+
+	//First paced frame: start the deadline chain from here
+	if (mNextFrameDeadline == std::chrono::steady_clock::time_point{})
+	{
+		mNextFrameDeadline = waitStart + period;
+		return;
+	}
+
+	auto slack = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(mPacingSleepSlackSeconds));
+
+	//Coarse sleep leaves the slack unslept and the spin finishes the
+	//rest; sleep granularity alone overshoots the budget by milliseconds
+	if (mNextFrameDeadline - waitStart > slack)
+	{
+		std::this_thread::sleep_for(mNextFrameDeadline - waitStart - slack);
+	}
+
+	while (std::chrono::steady_clock::now() < mNextFrameDeadline)
+	{
+		std::this_thread::yield();
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	mPacingWaitMs = std::chrono::duration<double, std::milli>(now - waitStart).count();
+
+	//Chain the next deadline; a frame that blew its budget restarts
+	//the chain instead of sprinting to repay the debt
+	mNextFrameDeadline += period;
+	if (mNextFrameDeadline < now)
+	{
+		mNextFrameDeadline = now + period;
+	}
+}
+
+/// <summary>
+/// Whether the primary or any extra window currently has input focus
+/// </summary>
+/// <returns></returns>
+bool VulkanRenderer::anyWindowFocused() const
+{
+	if (glfwGetWindowAttrib(mpWindow, GLFW_FOCUSED) == GLFW_TRUE)
+	{
+		return true;
+	}
+
+	for (const auto& windowSurface: mExtraWindows)
+	{
+		if (windowSurface.window != nullptr &&
+			glfwGetWindowAttrib(windowSurface.window, GLFW_FOCUSED) == GLFW_TRUE)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /// <summary>
 /// Submits commands to the command buffer to draw a frame
 /// </summary>
 void VulkanRenderer::drawFrame()
 {
+	auto frameStart = std::chrono::high_resolution_clock::now();
+
 	//Wait for fence without timeout
 	vkWaitForFences(mDevice, 1, &mInFlightFence[mCurrentFrame], VK_TRUE, UINT64_MAX);
 
+	//Frames that could reference retired swap chains or resources
+	//have drained by now
+	destroyRetiredSwapChains(false);
+	destroyRetiredResources(false);
+
+	//Extra windows flagged by a resize or a failed present rebuild
+	//their swap chains before this frame touches them
+	for (auto& windowSurface: mExtraWindows)
+	{
+		if (windowSurface.resized)
+		{
+			recreateExtraWindowSwapChain(windowSurface);
+		}
+	}
+
+	auto acquireStart = std::chrono::high_resolution_clock::now();
+	profileZoneBegin("Acquire");
+
 	//Get the index of the next image we will render
 	uint32_t imageIndex;
-	VkResult result = vkAcquireNextImageKHR(mDevice, mSwapChain, UINT64_MAX,
-	                      mImageAvailableSemaphore[mCurrentFrame], VK_NULL_HANDLE, &imageIndex);
 
-	if (result == VK_ERROR_OUT_OF_DATE_KHR)
+	if (mHeadless)
 	{
-		recreateSwapChain();
-		return;
+		//No presentation engine; cycle through the offscreen targets
+		imageIndex = (uint32_t)(mFrameNumber % mSwapChainImages.size());
+	} else
+	{
+		VkResult result = vkAcquireNextImageKHR(mDevice, mSwapChain, UINT64_MAX,
+		                      mImageAvailableSemaphore[mCurrentFrame], VK_NULL_HANDLE, &imageIndex);
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			recreateSwapChain();
+			return;
+		}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		{
+			throw std::runtime_error("ERROR: Failed to acquire swap chain image!\n");
+		}
+	}
+
+	//A frame from a different slot may still be rendering into this
+	//image; wait for it so queries and re-recording are safe
+	if (mImagesInFlight[imageIndex] != VK_NULL_HANDLE)
+	{
+		vkWaitForFences(mDevice, 1, &mImagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
 	}
-	else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+	mImagesInFlight[imageIndex] = mInFlightFence[mCurrentFrame];
+
+	//Acquire every extra window's image; a stale chain sits this
+	//frame out and is rebuilt on the next one
+	for (auto& windowSurface: mExtraWindows)
 	{
-		throw std::runtime_error("ERROR: Failed to acquire swap chain image!\n");
+		windowSurface.acquiredImage = UINT32_MAX;
+
+		if (windowSurface.resized)
+		{
+			continue;
+		}
+
+		uint32_t extraImageIndex;
+		VkResult result = vkAcquireNextImageKHR(mDevice, windowSurface.swapChain, UINT64_MAX,
+		                      windowSurface.imageAvailableSemaphores[mCurrentFrame], VK_NULL_HANDLE,
+		                      &extraImageIndex);
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			windowSurface.resized = true;
+			continue;
+		}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		{
+			throw std::runtime_error("ERROR: Failed to acquire swap chain image!\n");
+		}
+
+		if (windowSurface.imagesInFlight[extraImageIndex] != VK_NULL_HANDLE)
+		{
+			vkWaitForFences(mDevice, 1, &windowSurface.imagesInFlight[extraImageIndex],
+				VK_TRUE, UINT64_MAX);
+		}
+		windowSurface.imagesInFlight[extraImageIndex] = mInFlightFence[mCurrentFrame];
+
+		windowSurface.acquiredImage = extraImageIndex;
 	}
 
+	//Read back the GPU time and counters of this image's previous
+	//submission before we queue it up again
+	double gpuMs = readGpuFrameTime(imageIndex);
+
+	FrameSample sample{};
+	readGpuCounters(imageIndex, sample);
+
 	//Reset fence only if work is submitted, otherwise we will deadlock
 	vkResetFences(mDevice, 1, &mInFlightFence[mCurrentFrame]);
 
-	//Reset command buffer before recording
-	vkResetCommandBuffer(mCommandBuffers[mCurrentFrame], 0);
+	profileZoneEnd("Acquire");
+	auto recordStart = std::chrono::high_resolution_clock::now();
+	profileZoneBegin("Record");
+
+	//Rebuild the packed mesh buffers if meshes were registered mid-run
+	if (mMeshBuffersDirty)
+	{
+		buildMeshBuffers();
+	}
+
+	//Commands are identical between frames, so only re-record
+	//this image's buffer when something invalidated it
+	if (mCommandBufferDirty[imageIndex])
+	{
+		vkResetCommandBuffer(mCommandBuffers[imageIndex], 0);
+		recordCommandBuffer(mCommandBuffers[imageIndex], imageIndex);
+		mCommandBufferDirty[imageIndex] = false;
+	}
+
+	//Write this frame's shader globals before submitting
+	updateUniformBuffer(imageIndex);
+
+	//Extra windows re-record every frame: their buffers are cheap
+	//inline draws and must follow the shared uniform index
+	for (auto& windowSurface: mExtraWindows)
+	{
+		if (windowSurface.acquiredImage != UINT32_MAX)
+		{
+			recordExtraWindowCommands(windowSurface, windowSurface.acquiredImage, imageIndex);
+		}
+	}
 
-	recordCommandBuffer(mCommandBuffers[mCurrentFrame], imageIndex);
+	profileZoneEnd("Record");
+	auto submitStart = std::chrono::high_resolution_clock::now();
+	profileZoneBegin("Submit");
 
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	//Have semaphores wait at color writing stage
-	VkSemaphore waitSemaphores[] = {mImageAvailableSemaphore[mCurrentFrame]};
-	VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = waitSemaphores;
-	submitInfo.pWaitDstStageMask = waitStages;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &mCommandBuffers[mCurrentFrame];
+	//Have semaphores wait at color writing stage; headless runs have
+	//no acquire semaphore, the images-in-flight fence orders reuse
+	std::vector<VkSemaphore> waitSemaphores{};
+	std::vector<VkPipelineStageFlags> waitStages{};
 
-	//This semaphore is signaled once command execution is completed
-	VkSemaphore signalSemaphores[] = {mRenderFinishedSemaphore[mCurrentFrame]};
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = signalSemaphores;
+	if (!mHeadless)
+	{
+		waitSemaphores.push_back(mImageAvailableSemaphore[mCurrentFrame]);
+		waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+	}
+
+	//Graphics consumes the compute output, so hold vertex input
+	//until the dispatch on the compute queue has finished
+	if (mComputePending)
+	{
+		waitSemaphores.push_back(mComputeFinishedSemaphore);
+		waitStages.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+
+		//Finish the ownership transfer the dispatch released before
+		//anything on this queue reads the storage buffer
+		if (mComputeFamilyIndex != mGraphicsFamilyIndex)
+		{
+			mPendingAcquires.push_back({mComputeStorageBuffer, 0, VK_WHOLE_SIZE,
+				mComputeFamilyIndex});
+		}
+
+		mComputePending = false;
+	}
+
+	//Streamed uploads: wait on their copies and run the ownership
+	//acquires ahead of the draw commands in this same submit
+	std::vector<VkCommandBuffer> commandBuffers{};
+	if (!mPendingAcquires.empty())
+	{
+		recordStreamingAcquires(mAcquireCommandBuffers[mCurrentFrame]);
+		commandBuffers.push_back(mAcquireCommandBuffers[mCurrentFrame]);
+
+		for (auto& slot: mStreamingSlots)
+		{
+			if (slot.semaphorePending)
+			{
+				waitSemaphores.push_back(slot.copyComplete);
+				waitStages.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+				slot.semaphorePending = false;
+				slot.waitedAtFrame = mFrameNumber;
+			}
+		}
+	}
+	commandBuffers.push_back(mCommandBuffers[imageIndex]);
+
+	//Every extra window's frame rides in this same submit
+	for (auto& windowSurface: mExtraWindows)
+	{
+		if (windowSurface.acquiredImage == UINT32_MAX)
+		{
+			continue;
+		}
+
+		waitSemaphores.push_back(windowSurface.imageAvailableSemaphores[mCurrentFrame]);
+		waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		commandBuffers.push_back(windowSurface.commandBuffers[mCurrentFrame]);
+	}
+
+	submitInfo.waitSemaphoreCount = (uint32_t)waitSemaphores.size();
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitStages.data();
+	submitInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+	submitInfo.pCommandBuffers = commandBuffers.data();
+
+	//These semaphores are signaled once command execution is completed;
+	//they belong to the images so out-of-order acquisition can't
+	//re-signal a semaphore presentation hasn't consumed yet
+	//(nothing consumes them headless, so nothing is signaled)
+	std::vector<VkSemaphore> signalSemaphores{};
+
+	if (!mHeadless)
+	{
+		signalSemaphores.push_back(mRenderFinishedSemaphore[imageIndex]);
+
+		for (auto& windowSurface: mExtraWindows)
+		{
+			if (windowSurface.acquiredImage != UINT32_MAX)
+			{
+				signalSemaphores.push_back(
+					windowSurface.renderFinishedSemaphores[windowSurface.acquiredImage]);
+			}
+		}
+	}
+
+	submitInfo.signalSemaphoreCount = (uint32_t)signalSemaphores.size();
+	submitInfo.pSignalSemaphores = signalSemaphores.data();
 
 	if (vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, mInFlightFence[mCurrentFrame]) != VK_SUCCESS)
 	{
 		throw std::runtime_error("ERROR: Failed to submit draw command buffer!\n");
 	}
 
-	//Presentation info
-	VkPresentInfoKHR presentInfo{};
-	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	profileZoneEnd("Submit");
+	auto presentStart = std::chrono::high_resolution_clock::now();
+	profileZoneBegin("Present");
+
+	if (!mHeadless)
+	{
+		//One present carries every window's swap chain; per-chain
+		//results are collected so each window reacts on its own
+		std::vector<VkSwapchainKHR> swapChains = {mSwapChain};
+		std::vector<uint32_t> imageIndices = {imageIndex};
+
+		for (auto& windowSurface: mExtraWindows)
+		{
+			if (windowSurface.acquiredImage != UINT32_MAX)
+			{
+				swapChains.push_back(windowSurface.swapChain);
+				imageIndices.push_back(windowSurface.acquiredImage);
+			}
+		}
 
-	//Set our signal semaphore as the wait semaphore so
-	//the renderer waits until the commands are executed to render
-	presentInfo.waitSemaphoreCount = 1;
-	presentInfo.pWaitSemaphores = signalSemaphores;
+		std::vector<VkResult> presentResults(swapChains.size());
 
-	VkSwapchainKHR swapChains[] = {mSwapChain};
-	presentInfo.swapchainCount = 1;
-	presentInfo.pSwapchains = swapChains;
-	presentInfo.pImageIndices = &imageIndex;
-	presentInfo.pResults = nullptr;
+		//Presentation info
+		VkPresentInfoKHR presentInfo{};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
-	result = vkQueuePresentKHR(mPresentQueue, &presentInfo);
+		//Set our signal semaphores as the wait semaphores so
+		//the renderer waits until the commands are executed to render
+		presentInfo.waitSemaphoreCount = (uint32_t)signalSemaphores.size();
+		presentInfo.pWaitSemaphores = signalSemaphores.data();
 
-	//If it has been modified, attempt to recreate swap chain with new properties
-	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || mFramebufferResized)
-	{
-		mFramebufferResized = false;
-		recreateSwapChain();
+		presentInfo.swapchainCount = (uint32_t)swapChains.size();
+		presentInfo.pSwapchains = swapChains.data();
+		presentInfo.pImageIndices = imageIndices.data();
+		presentInfo.pResults = presentResults.data();
+
+		VkResult result = vkQueuePresentKHR(mPresentQueue, &presentInfo);
+
+		//If the primary chain has been modified, attempt to recreate
+		//the swap chain with new properties
+		if (presentResults[0] == VK_ERROR_OUT_OF_DATE_KHR ||
+		    presentResults[0] == VK_SUBOPTIMAL_KHR || mFramebufferResized)
+		{
+			mFramebufferResized = false;
+			recreateSwapChain();
+		}
+		else if (result != VK_SUCCESS && result != VK_ERROR_OUT_OF_DATE_KHR &&
+		         result != VK_SUBOPTIMAL_KHR)
+		{
+			throw std::runtime_error("ERROR: Failed to present swap chain image!\n");
+		}
+
+		//Extra windows rebuild only their own chains next frame
+		size_t resultIndex = 1;
+		for (auto& windowSurface: mExtraWindows)
+		{
+			if (windowSurface.acquiredImage == UINT32_MAX)
+			{
+				continue;
+			}
+
+			if (presentResults[resultIndex] == VK_ERROR_OUT_OF_DATE_KHR ||
+			    presentResults[resultIndex] == VK_SUBOPTIMAL_KHR)
+			{
+				windowSurface.resized = true;
+			}
+			resultIndex++;
+		}
 	}
-	else if (result != VK_SUCCESS)
+
+	//Late-latch: block until this frame's work finishes so input
+	//sampled next frame is as fresh as possible, at the cost of
+	//CPU/GPU overlap (the wait lands in presentMs)
+	if (mLatencyWaitEnabled)
 	{
-		throw std::runtime_error("ERROR: Failed to present swap chain image!\n");
+		vkWaitForFences(mDevice, 1, &mInFlightFence[mCurrentFrame], VK_TRUE, UINT64_MAX);
 	}
 
-	mCurrentFrame = (mCurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	profileZoneEnd("Present");
+	auto frameEnd = std::chrono::high_resolution_clock::now();
+
+	//Record where this frame's CPU time went (the GPU counters were
+	//filled in fence-late above)
+	sample.frameMs = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+	sample.acquireMs = std::chrono::duration<double, std::milli>(recordStart - acquireStart).count();
+	sample.recordMs = std::chrono::duration<double, std::milli>(submitStart - recordStart).count();
+	sample.submitMs = std::chrono::duration<double, std::milli>(presentStart - submitStart).count();
+	sample.presentMs = std::chrono::duration<double, std::milli>(frameEnd - presentStart).count();
+	sample.gpuMs = gpuMs;
+	sample.pacingWaitMs = mPacingWaitMs;
+	mFrameStats.recordFrame(sample);
+
+	mCurrentFrame = (mCurrentFrame + 1) % mMaxFramesInFlight;
+	mFrameNumber++;
 }
 
 #pragma region Window/Vulkan Creation Functions
@@ -195,6 +832,12 @@ void VulkanRenderer::createWindow()
 /// </summary>
 void VulkanRenderer::createInstance()
 {
+	//enumerateDevices may have created the instance before init ran
+	if (mInstance != VK_NULL_HANDLE)
+	{
+		return;
+	}
+
 	//Setup app info
 	VkApplicationInfo appinfo{};
 	appinfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -202,7 +845,10 @@ void VulkanRenderer::createInstance()
 	appinfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	appinfo.pEngineName = "No Engine";
 	appinfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	appinfo.apiVersion = VK_API_VERSION_1_0;
+
+	//1.1 for vkGetPhysicalDeviceFeatures2, which the dynamic
+	//rendering support query needs
+	appinfo.apiVersion = VK_API_VERSION_1_1;
 
 	//Setup instance creation info
 	VkInstanceCreateInfo createInfo{};
@@ -266,22 +912,143 @@ void VulkanRenderer::createSurface()
 }
 
 /// <summary>
-///	Sets off the frame buffer resized flag
+/// Creates the GLFW window and surface for every extra window
+/// registered through addWindow
+/// </summary>
+void VulkanRenderer::createExtraWindows()
+{
+	for (auto& windowSurface: mExtraWindows)
+	{
+		//glfwInit and the client API hint already ran in createWindow
+		windowSurface.window = glfwCreateWindow((int)windowSurface.width,
+			(int)windowSurface.height, windowSurface.title.c_str(), nullptr, nullptr);
+		glfwSetWindowUserPointer(windowSurface.window, this);
+		glfwSetFramebufferSizeCallback(windowSurface.window, framebufferResizeCallback);
+
+		if (glfwCreateWindowSurface(mInstance, windowSurface.window, nullptr,
+		    &windowSurface.surface) != VK_SUCCESS)
+		{
+			throw std::runtime_error("ERROR: Failed to create a window surface!\n");
+		}
+	}
+}
+
+/// <summary>
+///	Sets off the frame buffer resized flag
 /// </summary>
 void VulkanRenderer::framebufferResizeCallback(GLFWwindow *window, int width, int height)
 {
 	auto app = (VulkanRenderer*)glfwGetWindowUserPointer(window);
-	app->mFramebufferResized = true;
+
+	if (window == app->mpWindow)
+	{
+		app->mFramebufferResized = true;
+		return;
+	}
+
+	//An extra window rebuilds only its own swap chain
+	for (auto& windowSurface: app->mExtraWindows)
+	{
+		if (windowSurface.window == window)
+		{
+			windowSurface.resized = true;
+		}
+	}
 }
 #pragma endregion
 
 #pragma region Device Creation Methods
 /// <summary>
-/// Sets up the GPU and selects the best available
+/// Sets up the GPU, honoring an explicit index/UUID pin when one was
+/// set and falling back to the best-scoring suitable device otherwise
 /// </summary>
 void VulkanRenderer::pickPhysicalDevice()
 {
-	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	std::vector<DeviceInfo> deviceInfos = enumerateDevices();
+
+	uint32_t deviceCount = (uint32_t)deviceInfos.size();
+	std::vector<VkPhysicalDevice> devices(deviceCount);
+	vkEnumeratePhysicalDevices(mInstance, &deviceCount, devices.data());
+
+	std::optional<uint32_t> pickedIndex{};
+
+	if (mPreferredDeviceUuid.has_value())
+	{
+		for (const auto& info: deviceInfos)
+		{
+			if (info.uuid == *mPreferredDeviceUuid)
+			{
+				pickedIndex = info.index;
+				break;
+			}
+		}
+
+		if (!pickedIndex.has_value())
+		{
+			throw std::runtime_error("ERROR: No device matches the requested UUID!\n");
+		}
+	} else if (mPreferredDeviceIndex.has_value())
+	{
+		if (*mPreferredDeviceIndex >= deviceCount)
+		{
+			throw std::runtime_error("ERROR: The requested device index is out of range!\n");
+		}
+
+		pickedIndex = *mPreferredDeviceIndex;
+	} else
+	{
+		//Heuristic: the best-scoring suitable device wins
+		int bestScore = 0;
+		for (const auto& info: deviceInfos)
+		{
+			if (info.suitable && info.score > bestScore)
+			{
+				bestScore = info.score;
+				pickedIndex = info.index;
+			}
+		}
+
+		if (!pickedIndex.has_value())
+		{
+			throw std::runtime_error("ERROR: Failed to find a suitable GPU\n");
+		}
+	}
+
+	//A pinned device must still pass the mandatory checks; failing
+	//loudly beats rendering on a device that can't present
+	if (!deviceInfos[*pickedIndex].suitable)
+	{
+		throw std::runtime_error("ERROR: The requested device is not usable: " +
+			deviceInfos[*pickedIndex].rejectionReason + "!\n");
+	}
+
+	mPhysicalDevice = devices[*pickedIndex];
+
+	//Use dynamic rendering when requested and the device has it;
+	//otherwise the render-pass path below stays in effect
+	if (mDynamicRenderingEnabled)
+	{
+		mDynamicRenderingActive = checkDynamicRenderingSupport(mPhysicalDevice);
+	}
+}
+
+/// <summary>
+/// Enumerates every adapter with its scoring breakdown; creates the
+/// instance on first use so selection can happen before init
+/// </summary>
+/// <returns></returns>
+std::vector<DeviceInfo> VulkanRenderer::enumerateDevices()
+{
+	if (mInstance == VK_NULL_HANDLE)
+	{
+		//getRequiredExtensions asks GLFW for the surface extensions,
+		//so GLFW must be up first (init repeats both calls harmlessly)
+		if (!mHeadless)
+		{
+			glfwInit();
+		}
+		createInstance();
+	}
 
 	//Query number of devices
 	uint32_t deviceCount = 0;
@@ -297,26 +1064,61 @@ void VulkanRenderer::pickPhysicalDevice()
 	std::vector<VkPhysicalDevice> devices(deviceCount);
 	vkEnumeratePhysicalDevices(mInstance, &deviceCount, devices.data());
 
-	//Map of available devices
-	std::multimap<int, VkPhysicalDevice> availableDevices;
+	std::vector<DeviceInfo> deviceInfos(deviceCount);
 
-	//Get suitability of all devices and add to ordered map
-	for (const auto &device: devices)
+	//Score every device in parallel; the checks are pure instance
+	//queries, so multi-GPU machines pay for one pass instead of N
+	tf::Taskflow scoringFlow;
+	for (uint32_t i = 0; i < deviceCount; i++)
 	{
-		int suitability = getDeviceSuitability(device);
-		availableDevices.insert(std::make_pair(suitability, device));
+		scoringFlow.emplace([this, &devices, &deviceInfos, i]
+		{
+			deviceInfos[i] = scoreDevice(devices[i], i);
+		});
 	}
+	mExecutor.run(scoringFlow).wait();
+
+	return deviceInfos;
+}
+
+/// <summary>
+/// Checks for the VK_KHR_dynamic_rendering extension and its feature bit
+/// </summary>
+/// <param name="device"></param>
+/// <returns></returns>
+bool VulkanRenderer::checkDynamicRenderingSupport(VkPhysicalDevice device) const
+{
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
-	//Get the highest rated device, if there is no device throw error
-	if (availableDevices.rbegin()->first > 0)
+	bool extensionPresent = false;
+	for (const auto& extension: availableExtensions)
 	{
-		physicalDevice = availableDevices.rbegin()->second;
-	} else
+		if (strcmp(extension.extensionName, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) == 0)
+		{
+			extensionPresent = true;
+			break;
+		}
+	}
+
+	if (!extensionPresent)
 	{
-		throw std::runtime_error("ERROR: Failed to find a suitable GPU\n");
+		return false;
 	}
 
-	mPhysicalDevice = physicalDevice;
+	//The extension can be exposed without the feature being usable
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+	VkPhysicalDeviceFeatures2 features2{};
+	features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features2.pNext = &dynamicRenderingFeatures;
+
+	vkGetPhysicalDeviceFeatures2(device, &features2);
+
+	return dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
 }
 
 /// <summary>
@@ -331,6 +1133,16 @@ void VulkanRenderer::createLogicalDevice()
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfoList;
 	std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
 
+	if (indices.computeFamily.has_value())
+	{
+		uniqueQueueFamilies.insert(indices.computeFamily.value());
+	}
+
+	if (indices.transferFamily.has_value())
+	{
+		uniqueQueueFamilies.insert(indices.transferFamily.value());
+	}
+
 	//Required even if only using one queue
 	float queuePriority = 1.0f;
 
@@ -346,8 +1158,33 @@ void VulkanRenderer::createLogicalDevice()
 	}
 
 	//Define what features we want
+	VkPhysicalDeviceFeatures availableFeatures{};
+	vkGetPhysicalDeviceFeatures(mPhysicalDevice, &availableFeatures);
+
 	VkPhysicalDeviceFeatures deviceFeatures{};
 
+	//Multi-draw indirect lets one vkCmdDrawIndexedIndirect
+	//cover every registered mesh
+	mMultiDrawIndirectSupported = availableFeatures.multiDrawIndirect == VK_TRUE;
+	deviceFeatures.multiDrawIndirect = availableFeatures.multiDrawIndirect;
+
+	//Anisotropic filtering for the texture sampler, when the
+	//hardware has it
+	VkPhysicalDeviceProperties deviceProperties{};
+	vkGetPhysicalDeviceProperties(mPhysicalDevice, &deviceProperties);
+
+	mSamplerAnisotropySupported = availableFeatures.samplerAnisotropy == VK_TRUE;
+	mMaxSamplerAnisotropy = deviceProperties.limits.maxSamplerAnisotropy;
+	deviceFeatures.samplerAnisotropy = availableFeatures.samplerAnisotropy;
+
+	//Pipeline-statistics queries, plus inherited queries so the
+	//counters keep counting inside the secondary command buffers
+	mGpuCountersActive = mGpuCountersEnabled &&
+		availableFeatures.pipelineStatisticsQuery == VK_TRUE &&
+		availableFeatures.inheritedQueries == VK_TRUE;
+	deviceFeatures.pipelineStatisticsQuery = mGpuCountersActive ? VK_TRUE : VK_FALSE;
+	deviceFeatures.inheritedQueries = mGpuCountersActive ? VK_TRUE : VK_FALSE;
+
 	//Device creation info
 	VkDeviceCreateInfo deviceCreateInfo{};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -359,9 +1196,28 @@ void VulkanRenderer::createLogicalDevice()
 	//Set features
 	deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
 
-	//Extension settings
-	deviceCreateInfo.enabledExtensionCount = (uint32_t) DEVICE_EXTENSIONS.size();
-	deviceCreateInfo.ppEnabledExtensionNames = DEVICE_EXTENSIONS.data();
+	//Extension settings; the swap chain extension is only needed
+	//when there is something to present to
+	std::vector<const char*> enabledExtensions{};
+
+	if (!mHeadless)
+	{
+		enabledExtensions.insert(enabledExtensions.end(),
+			DEVICE_EXTENSIONS.begin(), DEVICE_EXTENSIONS.end());
+	}
+
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+
+	if (mDynamicRenderingActive)
+	{
+		enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+		deviceCreateInfo.pNext = &dynamicRenderingFeatures;
+	}
+
+	deviceCreateInfo.enabledExtensionCount = (uint32_t) enabledExtensions.size();
+	deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 	//Validation layer settings
 	if (ENABLED_VALIDATION_LAYERS)
@@ -383,58 +1239,125 @@ void VulkanRenderer::createLogicalDevice()
 	vkGetDeviceQueue(mDevice, indices.graphicsFamily.value(), 0, &mGraphicsQueue);
 
 	vkGetDeviceQueue(mDevice, indices.presentFamily.value(), 0, &mPresentQueue);
+
+	if (indices.computeFamily.has_value())
+	{
+		vkGetDeviceQueue(mDevice, indices.computeFamily.value(), 0, &mComputeQueue);
+	}
+
+	if (indices.transferFamily.has_value())
+	{
+		vkGetDeviceQueue(mDevice, indices.transferFamily.value(), 0, &mTransferQueue);
+	}
+
+	if (mDynamicRenderingActive)
+	{
+		mCmdBeginRenderingKHR = (PFN_vkCmdBeginRenderingKHR)
+			vkGetDeviceProcAddr(mDevice, "vkCmdBeginRenderingKHR");
+		mCmdEndRenderingKHR = (PFN_vkCmdEndRenderingKHR)
+			vkGetDeviceProcAddr(mDevice, "vkCmdEndRenderingKHR");
+
+		//Fall back rather than crash if the loader can't resolve them
+		if (mCmdBeginRenderingKHR == nullptr || mCmdEndRenderingKHR == nullptr)
+		{
+			mDynamicRenderingActive = false;
+		}
+	}
 }
 
 /// <summary>
-/// Grades devices based on device features and properties
+/// Runs the mandatory checks and the scoring heuristic (or the
+/// application's callback) for one adapter; geometry shaders are
+/// deliberately not required, the renderer never uses one
 /// </summary>
 /// <param name="device"></param>
+/// <param name="index"></param>
 /// <returns></returns>
-int VulkanRenderer::getDeviceSuitability(VkPhysicalDevice device)
+DeviceInfo VulkanRenderer::scoreDevice(VkPhysicalDevice device, uint32_t index)
 {
-	int suitability = 0;
+	DeviceInfo info{};
+	info.index = index;
 
-	//Get device properties
-	VkPhysicalDeviceProperties deviceProperties;
-	vkGetPhysicalDeviceProperties(device, &deviceProperties);
+	//Identity: name, type, and the UUID used for pinning
+	VkPhysicalDeviceIDProperties idProperties{};
+	idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 properties2{};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties2.pNext = &idProperties;
+
+	vkGetPhysicalDeviceProperties2(device, &properties2);
+
+	const VkPhysicalDeviceProperties& deviceProperties = properties2.properties;
+	info.name = deviceProperties.deviceName;
+	info.deviceType = deviceProperties.deviceType;
+	memcpy(info.uuid.data(), idProperties.deviceUUID, VK_UUID_SIZE);
 
 	//Get device features
 	VkPhysicalDeviceFeatures deviceFeatures;
 	vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
 
-	//Discrete GPUs have a performance advantage
-	if (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+	//Check if indices contains any queue families; before init there
+	//is no surface to probe, so presentation can't be verified yet
+	QueueFamilyIndices indices = findQueueFamilies(device);
+	bool queuesComplete = (mHeadless || mSurface != VK_NULL_HANDLE)
+		? indices.isComplete() : indices.graphicsFamily.has_value();
+
+	if (!queuesComplete)
 	{
-		suitability += 1000;
+		info.rejectionReason = "missing a graphics or present queue family";
+		return info;
 	}
 
-	//Max possible size of textures affects graphics quality
-	suitability += (int)deviceProperties.limits.maxImageDimension2D;
-
-	//Program can't function without geometry shader
-	if (!deviceFeatures.geometryShader)
+	if (!checkDeviceExtensionSupport(device))
 	{
-		return 0;
+		info.rejectionReason = "missing required device extensions";
+		return info;
 	}
 
-	//Check if indices contains any queue families
-	QueueFamilyIndices indices = findQueueFamilies(device);
-	if (!indices.isComplete() || !checkDeviceExtensionSupport(device))
+	//Check for swap chain support; headless runs never touch the
+	//surface, so the checks would dereference a null handle
+	int surfaceScore = 0;
+	if (!mHeadless && mSurface != VK_NULL_HANDLE)
 	{
-		return 0;
+		SwapChainSupportDetails swapChainSupport = getSwapChainSupport(device);
+		if (swapChainSupport.formats.empty() && swapChainSupport.presentModes.empty())
+		{
+			info.rejectionReason = "no surface formats or present modes";
+			return info;
+		}
+
+		surfaceScore = (int)(swapChainSupport.formats.size() +
+			swapChainSupport.presentModes.size());
 	}
 
-	//Check for swap chain support
-	SwapChainSupportDetails swapChainSupport = getSwapChainSupport(device);
-	if (swapChainSupport.formats.empty() && swapChainSupport.presentModes.empty())
+	info.suitable = true;
+
+	//An application callback replaces the heuristic entirely
+	if (mDeviceScoringCallback != nullptr)
 	{
-		return 0;
-	} else
+		info.score = mDeviceScoringCallback(device, deviceProperties, deviceFeatures);
+		if (info.score <= 0)
+		{
+			info.suitable = false;
+			info.rejectionReason = "rejected by the scoring callback";
+		}
+		return info;
+	}
+
+	//Discrete GPUs have a performance advantage
+	if (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
 	{
-		suitability += (int) (swapChainSupport.formats.size() + swapChainSupport.presentModes.size());
+		info.typeScore = 1000;
 	}
 
-	return suitability;
+	//Max possible size of textures affects graphics quality
+	info.limitScore = (int)deviceProperties.limits.maxImageDimension2D;
+
+	info.surfaceScore = surfaceScore;
+	info.score = info.typeScore + info.limitScore + info.surfaceScore;
+
+	return info;
 }
 
 /// <summary>
@@ -455,6 +1378,13 @@ bool VulkanRenderer::checkDeviceExtensionSupport(VkPhysicalDevice device)
 
 	std::set<std::string> requiredExtensions(DEVICE_EXTENSIONS.begin(), DEVICE_EXTENSIONS.end());
 
+	//Render farm devices may not expose the swap chain extension,
+	//and headless runs don't need it
+	if (mHeadless)
+	{
+		requiredExtensions.erase(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	}
+
 	//Remove required extensions from the set
 	for (const auto &extension: availableExtensions)
 	{
@@ -484,8 +1414,8 @@ void VulkanRenderer::createSwapChain()
 
 	mSwapChainExtent = chooseSwapExtent(swapChainSupport.capabilities);
 
-	//Minimum number of images to function
-	uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+	//Minimum number of images to function plus the configured margin
+	uint32_t imageCount = swapChainSupport.capabilities.minImageCount + mSwapChainImageMargin;
 
 	if (swapChainSupport.capabilities.maxImageCount > 0 &&
 	    imageCount > swapChainSupport.capabilities.maxImageCount)
@@ -524,7 +1454,9 @@ void VulkanRenderer::createSwapChain()
 	createInfo.presentMode = presentMode;
 	createInfo.clipped = VK_TRUE;
 
-	createInfo.oldSwapchain = VK_NULL_HANDLE;
+	//Hand the previous chain to the driver so it can recycle
+	//presentable images instead of allocating fresh ones
+	createInfo.oldSwapchain = mSwapChain;
 
 	if (vkCreateSwapchainKHR(mDevice, &createInfo, nullptr, &mSwapChain) != VK_SUCCESS)
 	{
@@ -537,6 +1469,31 @@ void VulkanRenderer::createSwapChain()
 	vkGetSwapchainImagesKHR(mDevice, mSwapChain, &imageCount, mSwapChainImages.data());
 }
 
+/// <summary>
+/// Creates the offscreen color targets a headless run renders into
+/// in place of swap-chain images
+/// </summary>
+void VulkanRenderer::createHeadlessTargets()
+{
+	//Match what chooseSwapSurfaceFormat would have picked so shaders
+	//and readback see the same channel layout either way
+	mSwapChainImageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+	mSwapChainExtent = {WIDTH, HEIGHT};
+
+	mSwapChainImages.resize(HEADLESS_IMAGE_COUNT);
+	mHeadlessImageAllocations.resize(HEADLESS_IMAGE_COUNT);
+
+	for (uint32_t i = 0; i < HEADLESS_IMAGE_COUNT; i++)
+	{
+		//TRANSFER_SRC so finished frames can be read back
+		createImage(mSwapChainExtent.width, mSwapChainExtent.height, 1,
+			mSwapChainImageFormat, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			mSwapChainImages[i], mHeadlessImageAllocations[i]);
+	}
+}
+
 /// <summary>
 /// Creates image views and adds them to a member variable
 /// </summary>
@@ -587,109 +1544,583 @@ void VulkanRenderer::recreateSwapChain()
 		glfwWaitEvents();
 	}
 
-	vkDeviceWaitIdle(mDevice);
-
-	cleanupSwapChain();
-
+	//Present modes and margin settings can change how many images the
+	//new chain gets; every per-image resource must follow suit
+	const size_t oldImageCount = mSwapChainImages.size();
+
+	//Retire the live chain's objects instead of stalling the device;
+	//they are destroyed once every in-flight frame has drained
+	RetiredSwapChain retired{};
+	retired.swapChain = mSwapChain;
+	retired.imageViews = std::move(mSwapChainImageViews);
+	retired.framebuffers = std::move(mSwapChainFramebuffers);
+	retired.depthImage = mDepthImage;
+	retired.depthImageView = mDepthImageView;
+	retired.depthImageAllocation = mDepthImageAllocation;
+
+	//In-flight frames may still signal the old per-image semaphores
+	retired.renderFinishedSemaphores = std::move(mRenderFinishedSemaphore);
+	retired.retireFrame = mFrameNumber;
+	mRetiredSwapChains.push_back(std::move(retired));
+
+	//createSwapChain passes the retired handle as oldSwapchain
 	createSwapChain();
 	createImageViews();
-	createFramebuffers();
-}
+	createDepthResources();
 
-/// <summary>
-/// Cleanup old objects that rely on the swap chain
-/// </summary>
-void VulkanRenderer::cleanupSwapChain()
-{
-	for (auto framebuffer: mSwapChainFramebuffers)
+	//Dynamic rendering targets the new image views directly, so the
+	//resize path rebuilds no framebuffer objects at all
+	if (!mDynamicRenderingActive)
 	{
-		vkDestroyFramebuffer(mDevice, framebuffer, nullptr);
+		createFramebuffers();
 	}
 
-	for (auto imageView: mSwapChainImageViews)
+	//Fresh per-image semaphores and fence tracking for the new chain
+	mRenderFinishedSemaphore.resize(mSwapChainImages.size());
+	mImagesInFlight.assign(mSwapChainImages.size(), VK_NULL_HANDLE);
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for (auto& semaphore: mRenderFinishedSemaphore)
 	{
-		vkDestroyImageView(mDevice, imageView, nullptr);
+		if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+		{
+			throw std::runtime_error("ERROR: Failed to create synchronization objects!\n");
+		}
 	}
 
-	vkDestroySwapchainKHR(mDevice, mSwapChain, nullptr);
-}
+	//Everything else indexed per swap-chain image must match the new
+	//count, or a mid-run margin change leaves later frames indexing
+	//out of bounds. None of these have a retire path, so drain the
+	//device first; this only runs on the rare count-changing resize
+	if (mSwapChainImages.size() != oldImageCount)
+	{
+		vkDeviceWaitIdle(mDevice);
 
-/// <summary>
-/// Returns the swap chain support details of this machine
-/// </summary>
-/// <param name="device"></param>
-/// <returns></returns>
-SwapChainSupportDetails VulkanRenderer::getSwapChainSupport(VkPhysicalDevice device) const
-{
-	SwapChainSupportDetails details{};
+		vkFreeCommandBuffers(mDevice, mCommandPool,
+			(uint32_t)mCommandBuffers.size(), mCommandBuffers.data());
 
-	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, mSurface, &details.capabilities);
+		for (size_t image = 0; image < mSecondaryCommandBuffers.size(); image++)
+		{
+			for (uint32_t worker = 0; worker < mWorkerCount; worker++)
+			{
+				vkFreeCommandBuffers(mDevice, mWorkerCommandPools[worker], 1,
+					&mSecondaryCommandBuffers[image][worker]);
+			}
+		}
 
-	uint32_t formatCount = 0;
-	vkGetPhysicalDeviceSurfaceFormatsKHR(device, mSurface, &formatCount, nullptr);
+		createCommandBuffers();
 
-	//Resize vector to hold surface format data
-	if (formatCount != 0)
-	{
-		details.formats.resize(formatCount);
-		vkGetPhysicalDeviceSurfaceFormatsKHR(device, mSurface, &formatCount, details.formats.data());
+		for (size_t i = 0; i < mUniformBuffers.size(); i++)
+		{
+			vkDestroyBuffer(mDevice, mUniformBuffers[i], nullptr);
+			mAllocator.free(mUniformBufferAllocations[i]);
+		}
+
+		createUniformBuffers();
+
+		//Destroying the pool returns every set allocated from it
+		vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
+		createDescriptorPool();
+		createDescriptorSets();
+
+		//The query pools hold one slot per image as well; destroying
+		//VK_NULL_HANDLE is a no-op when a counter mode is off
+		vkDestroyQueryPool(mDevice, mTimestampQueryPool, nullptr);
+		vkDestroyQueryPool(mDevice, mPipelineStatsQueryPool, nullptr);
+		vkDestroyQueryPool(mDevice, mOcclusionQueryPool, nullptr);
+		mTimestampQueryPool = VK_NULL_HANDLE;
+		mPipelineStatsQueryPool = VK_NULL_HANDLE;
+		mOcclusionQueryPool = VK_NULL_HANDLE;
+		createTimestampQueryPool();
+		createGpuCounterQueryPools();
 	}
-	return details;
+
+	//The recorded framebuffer handles are stale now
+	markCommandBuffersDirty();
 }
 
 /// <summary>
-/// Chooses the best available surface format
+/// Destroys retired swap chains whose frames have all signaled their
+/// fences (everything older than mMaxFramesInFlight frames)
 /// </summary>
-/// <param name="availableFormats"></param>
-/// <returns></returns>
-VkSurfaceFormatKHR VulkanRenderer::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats)
+/// <param name="force"></param>
+void VulkanRenderer::destroyRetiredSwapChains(bool force)
 {
-	for (const auto &availableFormat: availableFormats)
+	for (size_t i = 0; i < mRetiredSwapChains.size();)
 	{
-		if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB &&
-		    availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+		RetiredSwapChain& retired = mRetiredSwapChains[i];
+
+		if (!force && mFrameNumber < retired.retireFrame + mMaxFramesInFlight)
 		{
-			return availableFormat;
+			i++;
+			continue;
+		}
+
+		for (auto framebuffer: retired.framebuffers)
+		{
+			vkDestroyFramebuffer(mDevice, framebuffer, nullptr);
 		}
+
+		for (auto imageView: retired.imageViews)
+		{
+			vkDestroyImageView(mDevice, imageView, nullptr);
+		}
+
+		vkDestroyImageView(mDevice, retired.depthImageView, nullptr);
+		vkDestroyImage(mDevice, retired.depthImage, nullptr);
+		mAllocator.free(retired.depthImageAllocation);
+
+		for (auto semaphore: retired.renderFinishedSemaphores)
+		{
+			vkDestroySemaphore(mDevice, semaphore, nullptr);
+		}
+
+		vkDestroySwapchainKHR(mDevice, retired.swapChain, nullptr);
+
+		mRetiredSwapChains.erase(mRetiredSwapChains.begin() + (long)i);
 	}
+}
 
-	//Return first format if none meet our specifications
-	return availableFormats[0];
+/// <summary>
+/// Queues a buffer for destruction once every frame that could
+/// still reference it has drained
+/// </summary>
+/// <param name="buffer"></param>
+/// <param name="allocation"></param>
+void VulkanRenderer::retireBuffer(VkBuffer buffer, const GpuAllocation& allocation)
+{
+	RetiredResource retired{};
+	retired.buffer = buffer;
+	retired.allocation = allocation;
+	retired.retireFrame = mFrameNumber;
+	mRetiredResources.push_back(retired);
 }
 
 /// <summary>
-/// Chooses the best available present mode
+/// Queues an image and its view for destruction once every frame
+/// that could still reference them has drained
 /// </summary>
-/// <param name="availablePresentModes"></param>
-/// <returns></returns>
-VkPresentModeKHR VulkanRenderer::chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes)
+/// <param name="image"></param>
+/// <param name="imageView"></param>
+/// <param name="allocation"></param>
+void VulkanRenderer::retireImage(VkImage image, VkImageView imageView,
+	const GpuAllocation& allocation)
 {
-	for (const auto &availablePresentMode: availablePresentModes)
+	RetiredResource retired{};
+	retired.image = image;
+	retired.imageView = imageView;
+	retired.allocation = allocation;
+	retired.retireFrame = mFrameNumber;
+	mRetiredResources.push_back(retired);
+}
+
+/// <summary>
+/// Destroys retired resources whose frames have all signaled their
+/// fences (everything older than mMaxFramesInFlight frames)
+/// </summary>
+/// <param name="force"></param>
+void VulkanRenderer::destroyRetiredResources(bool force)
+{
+	for (size_t i = 0; i < mRetiredResources.size();)
 	{
-		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+		RetiredResource& retired = mRetiredResources[i];
+
+		if (!force && mFrameNumber < retired.retireFrame + mMaxFramesInFlight)
 		{
-			return availablePresentMode;
+			i++;
+			continue;
 		}
+
+		//Destroying VK_NULL_HANDLE is a no-op, so unset handles
+		//need no special casing
+		vkDestroyBuffer(mDevice, retired.buffer, nullptr);
+		vkDestroyImageView(mDevice, retired.imageView, nullptr);
+		vkDestroyImage(mDevice, retired.image, nullptr);
+		mAllocator.free(retired.allocation);
+
+		mRetiredResources.erase(mRetiredResources.begin() + (long)i);
 	}
-	return VK_PRESENT_MODE_FIFO_KHR;
 }
 
 /// <summary>
-/// Chooses the min and maximum size of the display
+/// Cleanup old objects that rely on the swap chain
 /// </summary>
-/// <param name="capabilities"></param>
-/// <returns></returns>
-VkExtent2D VulkanRenderer::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities)
+void VulkanRenderer::cleanupSwapChain()
 {
-	if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
+	for (auto framebuffer: mSwapChainFramebuffers)
 	{
-		return capabilities.currentExtent;
-	} else
+		vkDestroyFramebuffer(mDevice, framebuffer, nullptr);
+	}
+
+	for (auto imageView: mSwapChainImageViews)
 	{
-		int width, height;
-		glfwGetFramebufferSize(mpWindow, &width, &height);
+		vkDestroyImageView(mDevice, imageView, nullptr);
+	}
 
-		VkExtent2D actualExtent = {
+	vkDestroyImageView(mDevice, mDepthImageView, nullptr);
+	vkDestroyImage(mDevice, mDepthImage, nullptr);
+	mAllocator.free(mDepthImageAllocation);
+
+	if (mHeadless)
+	{
+		//The offscreen targets are ours, not the swap chain's
+		for (size_t i = 0; i < mSwapChainImages.size(); i++)
+		{
+			vkDestroyImage(mDevice, mSwapChainImages[i], nullptr);
+			mAllocator.free(mHeadlessImageAllocations[i]);
+		}
+	} else
+	{
+		vkDestroySwapchainKHR(mDevice, mSwapChain, nullptr);
+	}
+}
+
+/// <summary>
+/// Builds one extra window's swap chain and everything hanging off
+/// it: image views, depth attachment, framebuffers, sync objects,
+/// and per-frame command buffers
+/// </summary>
+/// <param name="windowSurface"></param>
+void VulkanRenderer::createExtraWindowSwapChain(WindowSurface& windowSurface)
+{
+	//The mSurface-based support helpers can't be reused here, so
+	//query this window's surface directly
+	VkSurfaceCapabilitiesKHR capabilities{};
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice,
+		windowSurface.surface, &capabilities);
+
+	uint32_t formatCount = 0;
+	vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, windowSurface.surface,
+		&formatCount, nullptr);
+
+	std::vector<VkSurfaceFormatKHR> formats(formatCount);
+	vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, windowSurface.surface,
+		&formatCount, formats.data());
+
+	uint32_t presentModeCount = 0;
+	vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice, windowSurface.surface,
+		&presentModeCount, nullptr);
+
+	std::vector<VkPresentModeKHR> presentModes(presentModeCount);
+	vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice, windowSurface.surface,
+		&presentModeCount, presentModes.data());
+
+	//The render pass and pipelines are shared across windows, so
+	//every surface must run the primary chain's format
+	VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(formats);
+
+	if (surfaceFormat.format != mSwapChainImageFormat)
+	{
+		throw std::runtime_error("ERROR: Extra window surface format doesn't match the primary swap chain!\n");
+	}
+
+	if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
+	{
+		windowSurface.extent = capabilities.currentExtent;
+	} else
+	{
+		int width, height;
+		glfwGetFramebufferSize(windowSurface.window, &width, &height);
+
+		windowSurface.extent.width = std::clamp((uint32_t)width,
+			capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+		windowSurface.extent.height = std::clamp((uint32_t)height,
+			capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+	}
+
+	//Minimum number of images to function plus the configured margin
+	uint32_t imageCount = capabilities.minImageCount + mSwapChainImageMargin;
+
+	if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount)
+	{
+		imageCount = capabilities.maxImageCount;
+	}
+
+	VkSwapchainCreateInfoKHR createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+	createInfo.surface = windowSurface.surface;
+
+	createInfo.minImageCount = imageCount;
+	createInfo.imageFormat = mSwapChainImageFormat;
+	createInfo.imageColorSpace = surfaceFormat.colorSpace;
+	createInfo.imageExtent = windowSurface.extent;
+	createInfo.imageArrayLayers = 1;
+	createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+	QueueFamilyIndices indices = findQueueFamilies(mPhysicalDevice);
+	uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+
+	if (indices.graphicsFamily != indices.presentFamily)
+	{
+		createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = 2;
+		createInfo.pQueueFamilyIndices = queueFamilyIndices;
+	} else
+	{
+		createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		createInfo.queueFamilyIndexCount = 0;
+		createInfo.pQueueFamilyIndices = nullptr;
+	}
+
+	createInfo.preTransform = capabilities.currentTransform;
+	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+	createInfo.presentMode = chooseSwapPresentMode(presentModes);
+	createInfo.clipped = VK_TRUE;
+	createInfo.oldSwapchain = windowSurface.swapChain;
+
+	if (vkCreateSwapchainKHR(mDevice, &createInfo, nullptr, &windowSurface.swapChain) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create swap chain!\n");
+	}
+
+	vkGetSwapchainImagesKHR(mDevice, windowSurface.swapChain, &imageCount, nullptr);
+	windowSurface.images.resize(imageCount);
+	vkGetSwapchainImagesKHR(mDevice, windowSurface.swapChain, &imageCount,
+		windowSurface.images.data());
+
+	windowSurface.imageViews.resize(imageCount);
+
+	for (uint32_t i = 0; i < imageCount; i++)
+	{
+		windowSurface.imageViews[i] = createImageView(windowSurface.images[i],
+			mSwapChainImageFormat, 1);
+	}
+
+	//This window's own depth attachment, sized to its extent
+	createImage(windowSurface.extent.width, windowSurface.extent.height, 1,
+		mDepthFormat, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		windowSurface.depthImage, windowSurface.depthImageAllocation);
+
+	windowSurface.depthImageView = createImageView(windowSurface.depthImage,
+		mDepthFormat, 1, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+	//Dynamic rendering targets the image views directly
+	if (!mDynamicRenderingActive)
+	{
+		windowSurface.framebuffers.resize(imageCount);
+
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			std::array<VkImageView, 2> attachments = {
+				windowSurface.imageViews[i],
+				windowSurface.depthImageView
+			};
+
+			VkFramebufferCreateInfo framebufferInfo{};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = mRenderPass;
+			framebufferInfo.attachmentCount = (uint32_t)attachments.size();
+			framebufferInfo.pAttachments = attachments.data();
+			framebufferInfo.width = windowSurface.extent.width;
+			framebufferInfo.height = windowSurface.extent.height;
+			framebufferInfo.layers = 1;
+
+			if (vkCreateFramebuffer(mDevice, &framebufferInfo, nullptr,
+				&windowSurface.framebuffers[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("ERROR: Failed to create framebuffer\n");
+			}
+		}
+	}
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	//Render-finished semaphores belong to the images they signal for
+	windowSurface.renderFinishedSemaphores.resize(imageCount);
+	windowSurface.imagesInFlight.assign(imageCount, VK_NULL_HANDLE);
+
+	for (auto& semaphore: windowSurface.renderFinishedSemaphores)
+	{
+		if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+		{
+			throw std::runtime_error("ERROR: Failed to create synchronization objects!\n");
+		}
+	}
+
+	//Acquire semaphores and command buffers are per frame in flight
+	//and survive swap-chain recreation, so build them only once
+	if (windowSurface.imageAvailableSemaphores.empty())
+	{
+		windowSurface.imageAvailableSemaphores.resize(mMaxFramesInFlight);
+
+		for (auto& semaphore: windowSurface.imageAvailableSemaphores)
+		{
+			if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+			{
+				throw std::runtime_error("ERROR: Failed to create synchronization objects!\n");
+			}
+		}
+
+		windowSurface.commandBuffers.resize(mMaxFramesInFlight);
+
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = mCommandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = (uint32_t)windowSurface.commandBuffers.size();
+
+		if (vkAllocateCommandBuffers(mDevice, &allocateInfo,
+			windowSurface.commandBuffers.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("ERROR: Failed to create command buffers!\n");
+		}
+	}
+}
+
+/// <summary>
+/// Destroys one extra window's swap chain and the objects hanging
+/// off it; the caller guarantees the GPU is done with them
+/// </summary>
+/// <param name="windowSurface"></param>
+void VulkanRenderer::destroyExtraWindowSwapChain(WindowSurface& windowSurface)
+{
+	for (auto framebuffer: windowSurface.framebuffers)
+	{
+		vkDestroyFramebuffer(mDevice, framebuffer, nullptr);
+	}
+	windowSurface.framebuffers.clear();
+
+	for (auto imageView: windowSurface.imageViews)
+	{
+		vkDestroyImageView(mDevice, imageView, nullptr);
+	}
+	windowSurface.imageViews.clear();
+
+	vkDestroyImageView(mDevice, windowSurface.depthImageView, nullptr);
+	vkDestroyImage(mDevice, windowSurface.depthImage, nullptr);
+	mAllocator.free(windowSurface.depthImageAllocation);
+
+	for (auto semaphore: windowSurface.renderFinishedSemaphores)
+	{
+		vkDestroySemaphore(mDevice, semaphore, nullptr);
+	}
+	windowSurface.renderFinishedSemaphores.clear();
+
+	vkDestroySwapchainKHR(mDevice, windowSurface.swapChain, nullptr);
+	windowSurface.swapChain = VK_NULL_HANDLE;
+}
+
+/// <summary>
+/// Recreates one extra window's swap chain after a resize; these are
+/// rare on fixed installations, so a full idle is simpler than
+/// retiring another set of objects
+/// </summary>
+/// <param name="windowSurface"></param>
+void VulkanRenderer::recreateExtraWindowSwapChain(WindowSurface& windowSurface)
+{
+	int width = 0, height = 0;
+	glfwGetFramebufferSize(windowSurface.window, &width, &height);
+
+	//Stay flagged until the window is visible again; the other
+	//windows keep rendering meanwhile
+	if (width == 0 || height == 0)
+	{
+		return;
+	}
+
+	vkDeviceWaitIdle(mDevice);
+
+	destroyExtraWindowSwapChain(windowSurface);
+	createExtraWindowSwapChain(windowSurface);
+
+	windowSurface.resized = false;
+}
+
+/// <summary>
+/// Returns the swap chain support details of this machine
+/// </summary>
+/// <param name="device"></param>
+/// <returns></returns>
+SwapChainSupportDetails VulkanRenderer::getSwapChainSupport(VkPhysicalDevice device) const
+{
+	SwapChainSupportDetails details{};
+
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, mSurface, &details.capabilities);
+
+	uint32_t formatCount = 0;
+	vkGetPhysicalDeviceSurfaceFormatsKHR(device, mSurface, &formatCount, nullptr);
+
+	//Resize vector to hold surface format data
+	if (formatCount != 0)
+	{
+		details.formats.resize(formatCount);
+		vkGetPhysicalDeviceSurfaceFormatsKHR(device, mSurface, &formatCount, details.formats.data());
+	}
+
+	uint32_t presentModeCount = 0;
+	vkGetPhysicalDeviceSurfacePresentModesKHR(device, mSurface, &presentModeCount, nullptr);
+
+	//Without this query every present-mode preference silently
+	//degraded to the FIFO fallback
+	if (presentModeCount != 0)
+	{
+		details.presentModes.resize(presentModeCount);
+		vkGetPhysicalDeviceSurfacePresentModesKHR(device, mSurface,
+			&presentModeCount, details.presentModes.data());
+	}
+
+	return details;
+}
+
+/// <summary>
+/// Chooses the best available surface format
+/// </summary>
+/// <param name="availableFormats"></param>
+/// <returns></returns>
+VkSurfaceFormatKHR VulkanRenderer::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats)
+{
+	for (const auto &availableFormat: availableFormats)
+	{
+		if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB &&
+		    availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+		{
+			return availableFormat;
+		}
+	}
+
+	//Return first format if none meet our specifications
+	return availableFormats[0];
+}
+
+/// <summary>
+/// Chooses the application's preferred present mode when the
+/// surface offers it; FIFO is the only mode the spec guarantees
+/// </summary>
+/// <param name="availablePresentModes"></param>
+/// <returns></returns>
+VkPresentModeKHR VulkanRenderer::chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes)
+{
+	for (const auto &availablePresentMode: availablePresentModes)
+	{
+		if (availablePresentMode == mPreferredPresentMode)
+		{
+			return availablePresentMode;
+		}
+	}
+	return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+/// <summary>
+/// Chooses the min and maximum size of the display
+/// </summary>
+/// <param name="capabilities"></param>
+/// <returns></returns>
+VkExtent2D VulkanRenderer::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities)
+{
+	if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
+	{
+		return capabilities.currentExtent;
+	} else
+	{
+		int width, height;
+		glfwGetFramebufferSize(mpWindow, &width, &height);
+
+		VkExtent2D actualExtent = {
 			(uint32_t) width,
 			(uint32_t) height
 		};
@@ -730,14 +2161,19 @@ QueueFamilyIndices VulkanRenderer::findQueueFamilies(VkPhysicalDevice device) co
 	int queueFamilyIndex = 0;
 	VkBool32 presentSupport = false;
 
-	//Find available queue families that support graphics commands
-	// and windows surface presentation
+	//Find available queue families that support graphics commands,
+	//windows surface presentation, compute dispatch, and transfers
 	for (const auto &queueFamily: queueFamilies)
 	{
 		if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
 		{
 			indices.graphicsFamily = queueFamilyIndex;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, queueFamilyIndex, mSurface, &presentSupport);
+
+			//Headless runs have no surface to query
+			if (mSurface != VK_NULL_HANDLE)
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, queueFamilyIndex, mSurface, &presentSupport);
+			}
 		}
 
 		//Store presentation family queue index if presentation is supported
@@ -746,14 +2182,49 @@ QueueFamilyIndices VulkanRenderer::findQueueFamilies(VkPhysicalDevice device) co
 			indices.presentFamily = queueFamilyIndex;
 		}
 
-		//Break out of loop early if complete
-		if (indices.isComplete())
+		//Prefer a dedicated compute family (no graphics bit) so
+		//dispatches can run alongside the render pass
+		if (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)
 		{
-			break;
+			if (!(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				indices.computeFamily = queueFamilyIndex;
+			} else if (!indices.computeFamily.has_value())
+			{
+				indices.computeFamily = queueFamilyIndex;
+			}
 		}
+
+		//Prefer a transfer-only family (usually the DMA engine) so
+		//streamed uploads overlap rendering entirely
+		if (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT)
+		{
+			if (!(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+			{
+				indices.transferFamily = queueFamilyIndex;
+			} else if (!indices.transferFamily.has_value())
+			{
+				indices.transferFamily = queueFamilyIndex;
+			}
+		}
+
 		queueFamilyIndex++;
 	}
 
+	//Graphics queues accept transfer work even when the flag isn't
+	//reported, so fall back to the graphics family
+	if (!indices.transferFamily.has_value())
+	{
+		indices.transferFamily = indices.graphicsFamily;
+	}
+
+	//Nothing is presented headless; the graphics family stands in
+	//so isComplete() keeps working
+	if (mHeadless)
+	{
+		indices.presentFamily = indices.graphicsFamily;
+	}
+
 	return indices;
 }
 #pragma endregion
@@ -764,6 +2235,8 @@ QueueFamilyIndices VulkanRenderer::findQueueFamilies(VkPhysicalDevice device) co
 /// </summary>
 void VulkanRenderer::createRenderPass()
 {
+	mDepthFormat = findDepthFormat();
+
 	VkAttachmentDescription colorAttachment{};
 	colorAttachment.format = mSwapChainImageFormat;
 
@@ -779,34 +2252,59 @@ void VulkanRenderer::createRenderPass()
 	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
-	//Set image layout to be unspecified
+	//Set image layout to be unspecified; headless frames end ready
+	//for readback instead of presentation
 	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorAttachment.finalLayout = mHeadless ?
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+	//Depth attachment; contents are cleared each frame and never
+	//stored, so tiled GPUs can keep it on chip
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = mDepthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 	//Sub pass layout
 	VkAttachmentReference colorAttachmentRef{};
 	colorAttachmentRef.attachment = 0;
 	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+	VkAttachmentReference depthAttachmentRef{};
+	depthAttachmentRef.attachment = 1;
+	depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
 	//Sub pass description
 	VkSubpassDescription subpass{};
 	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 	subpass.colorAttachmentCount = 1;
 	subpass.pColorAttachments = &colorAttachmentRef;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
 	VkSubpassDependency dependency{};
 	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 	dependency.dstSubpass = 0;
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 	dependency.srcAccessMask = 0;
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	std::array<VkAttachmentDescription, 2> attachments =
+		{colorAttachment, depthAttachment};
 
 	//Render create info
 	VkRenderPassCreateInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	renderPassInfo.attachmentCount = 1;
-	renderPassInfo.pAttachments = &colorAttachment;
+	renderPassInfo.attachmentCount = (uint32_t)attachments.size();
+	renderPassInfo.pAttachments = attachments.data();
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
 	renderPassInfo.dependencyCount = 1;
@@ -819,32 +2317,195 @@ void VulkanRenderer::createRenderPass()
 }
 
 /// <summary>
-/// Creates the programmable and fixed functions in the graphics pipeline
+/// Picks the first candidate format the device supports with the
+/// requested tiling and features
 /// </summary>
-void VulkanRenderer::createGraphicsPipeline()
+/// <param name="candidates"></param>
+/// <param name="tiling"></param>
+/// <param name="features"></param>
+/// <returns></returns>
+VkFormat VulkanRenderer::findSupportedFormat(const std::vector<VkFormat>& candidates,
+	VkImageTiling tiling, VkFormatFeatureFlags features) const
 {
-	//Cache shader code as binary
-	auto vertShaderCode = readFile("../shaders/vert.spv");
-	auto fragShaderCode = readFile("../shaders/frag.spv");
+	for (VkFormat format: candidates)
+	{
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(mPhysicalDevice, format, &properties);
 
-	VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-	VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+		if (tiling == VK_IMAGE_TILING_LINEAR &&
+		    (properties.linearTilingFeatures & features) == features)
+		{
+			return format;
+		}
+		if (tiling == VK_IMAGE_TILING_OPTIMAL &&
+		    (properties.optimalTilingFeatures & features) == features)
+		{
+			return format;
+		}
+	}
 
-	//Programmable pipeline creation info for vertex shader
-	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	throw std::runtime_error("ERROR: Failed to find a supported format!\n");
+}
 
-	vertShaderStageInfo.module = vertShaderModule;
-	vertShaderStageInfo.pName = "main";
+/// <summary>
+/// Chooses the depth attachment format, preferring higher precision
+/// </summary>
+/// <returns></returns>
+VkFormat VulkanRenderer::findDepthFormat() const
+{
+	return findSupportedFormat(
+		{VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+}
 
-	//We can set shader constants here
-	vertShaderStageInfo.pSpecializationInfo = nullptr;
+/// <summary>
+/// Creates the depth image and view at the swap chain's extent
+/// </summary>
+void VulkanRenderer::createDepthResources()
+{
+	createImage(mSwapChainExtent.width, mSwapChainExtent.height, 1,
+		mDepthFormat, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		mDepthImage, mDepthImageAllocation);
+
+	//The render pass transitions the layout from UNDEFINED itself
+	mDepthImageView = createImageView(mDepthImage, mDepthFormat, 1,
+		VK_IMAGE_ASPECT_DEPTH_BIT);
+}
 
-	//Creation info for fragment shader
-	VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-	fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+/// <summary>
+/// Creates the pipeline cache, seeding it from disk when a
+/// cache from a previous run matches this device
+/// </summary>
+void VulkanRenderer::createPipelineCache()
+{
+	VkPipelineCacheCreateInfo cacheInfo{};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+	std::vector<char> cacheData;
+
+	if (std::filesystem::exists(PIPELINE_CACHE_FILE))
+	{
+		cacheData = readFile(PIPELINE_CACHE_FILE);
+
+		//Validate the cache header against this device before trusting it;
+		//a cache from another GPU or driver version must be discarded
+		if (cacheData.size() >= sizeof(uint32_t) * 4 + VK_UUID_SIZE)
+		{
+			VkPhysicalDeviceProperties deviceProperties;
+			vkGetPhysicalDeviceProperties(mPhysicalDevice, &deviceProperties);
+
+			uint32_t headerVersion, vendorID, deviceID;
+			memcpy(&headerVersion, cacheData.data() + sizeof(uint32_t), sizeof(uint32_t));
+			memcpy(&vendorID, cacheData.data() + sizeof(uint32_t) * 2, sizeof(uint32_t));
+			memcpy(&deviceID, cacheData.data() + sizeof(uint32_t) * 3, sizeof(uint32_t));
+
+			if (headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			    vendorID == deviceProperties.vendorID &&
+			    deviceID == deviceProperties.deviceID &&
+			    memcmp(cacheData.data() + sizeof(uint32_t) * 4,
+			           deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0)
+			{
+				cacheInfo.initialDataSize = cacheData.size();
+				cacheInfo.pInitialData = cacheData.data();
+			}
+		}
+	}
+
+	if (vkCreatePipelineCache(mDevice, &cacheInfo, nullptr, &mPipelineCache) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create pipeline cache!\n");
+	}
+}
+
+/// <summary>
+/// Serializes the pipeline cache to disk for the next launch
+/// </summary>
+void VulkanRenderer::savePipelineCache()
+{
+	if (mPipelineCache == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	size_t cacheSize = 0;
+	if (vkGetPipelineCacheData(mDevice, mPipelineCache, &cacheSize, nullptr) != VK_SUCCESS ||
+	    cacheSize == 0)
+	{
+		return;
+	}
+
+	std::vector<char> cacheData(cacheSize);
+	if (vkGetPipelineCacheData(mDevice, mPipelineCache, &cacheSize, cacheData.data()) != VK_SUCCESS)
+	{
+		return;
+	}
+
+	std::ofstream file(PIPELINE_CACHE_FILE, std::ios::binary | std::ios::trunc);
+	if (file.is_open())
+	{
+		file.write(cacheData.data(), (long)cacheSize);
+	}
+}
+
+/// <summary>
+/// Creates the programmable and fixed functions in the graphics pipeline
+/// </summary>
+void VulkanRenderer::createGraphicsPipeline()
+{
+	//Specify uniforms in pipeline layout
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &mDescriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 0;
+	pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+	if (vkCreatePipelineLayout(mDevice, &pipelineLayoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create pipeline layout!\n");
+	}
+
+	//The base pipeline every library variant derives from
+	mGraphicsPipeline = buildGraphicsPipeline(PipelineKey{},
+		mPipelineCache, VK_NULL_HANDLE);
+}
+
+/// <summary>
+/// Builds one graphics pipeline for the given render-state variant;
+/// passing a base pipeline makes it a derivative, otherwise the
+/// result allows derivatives. Safe to call from worker threads as
+/// long as each uses its own pipeline cache.
+/// </summary>
+/// <param name="key"></param>
+/// <param name="cache"></param>
+/// <param name="basePipeline"></param>
+/// <returns></returns>
+VkPipeline VulkanRenderer::buildGraphicsPipeline(const PipelineKey& key,
+	VkPipelineCache cache, VkPipeline basePipeline)
+{
+	//Modules come from the shader cache, so rebuilding a pipeline
+	//never re-reads or re-creates them
+	VkShaderModule vertShaderModule = mShaderManager.getModule("../shaders/vert.spv");
+	VkShaderModule fragShaderModule = mShaderManager.getModule("../shaders/frag.spv");
+
+	//Programmable pipeline creation info for vertex shader
+	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+
+	vertShaderStageInfo.module = vertShaderModule;
+	vertShaderStageInfo.pName = "main";
+
+	//We can set shader constants here
+	vertShaderStageInfo.pSpecializationInfo = nullptr;
+
+	//Creation info for fragment shader
+	VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+	fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 	fragShaderStageInfo.module = fragShaderModule;
 	fragShaderStageInfo.pName = "main";
 
@@ -866,12 +2527,13 @@ void VulkanRenderer::createGraphicsPipeline()
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-	auto bindingDescriptions = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	//Both arrays are generated at compile time from the stream
+	//structs the mesh buffers are actually packed with
+	auto bindingDescriptions = MeshVertexLayout::getBindingDescriptions();
+	auto attributeDescriptions = MeshVertexLayout::getAttributeDescriptions();
 
-	//Set vertex binding to null for now because we are using hard-coded values
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescriptions;
+	vertexInputInfo.vertexBindingDescriptionCount = (uint32_t)bindingDescriptions.size();
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 	vertexInputInfo.vertexAttributeDescriptionCount = (uint32_t)attributeDescriptions.size();
 	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
@@ -908,10 +2570,10 @@ void VulkanRenderer::createGraphicsPipeline()
 	//If enabled, instead of clipping geometry out of far-plane it is clamped
 	rasterizer.depthClampEnable = VK_FALSE;
 	rasterizer.rasterizerDiscardEnable = VK_FALSE;
-	//Change render mode here (wireframe, fill, point)
-	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	//Render mode (wireframe, fill, point) comes from the variant key
+	rasterizer.polygonMode = key.polygonMode;
 	rasterizer.lineWidth = 1.0f;
-	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterizer.cullMode = key.cullMode;
 	rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
 	rasterizer.depthBiasEnable = VK_FALSE;
 	rasterizer.depthBiasConstantFactor = 0.0f;
@@ -928,8 +2590,15 @@ void VulkanRenderer::createGraphicsPipeline()
 	multisampling.alphaToCoverageEnable = VK_FALSE;
 	multisampling.alphaToOneEnable = VK_FALSE;
 
-	//Depth and stencil testing
-	VkPipelineDepthStencilStateCreateInfo *depthBuffer = nullptr;
+	//Depth testing: standard less-than test with writes, which the
+	//hardware can run before the fragment shader (early-Z)
+	VkPipelineDepthStencilStateCreateInfo depthStencil{};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = key.depthTest ? VK_TRUE : VK_FALSE;
+	depthStencil.depthWriteEnable = key.depthWrite ? VK_TRUE : VK_FALSE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.stencilTestEnable = VK_FALSE;
 
 	//Color Blending
 	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
@@ -947,276 +2616,2795 @@ void VulkanRenderer::createGraphicsPipeline()
 	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
 	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
 
-	//Framebuffer blend constants
-	VkPipelineColorBlendStateCreateInfo colorBlending{};
-	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	colorBlending.logicOpEnable = VK_FALSE;
-	colorBlending.logicOp = VK_LOGIC_OP_COPY;
-	colorBlending.attachmentCount = 1;
-	colorBlending.pAttachments = &colorBlendAttachment;
-	colorBlending.blendConstants[0] = 0.0f;
-	colorBlending.blendConstants[1] = 0.0f;
-	colorBlending.blendConstants[2] = 0.0f;
-	colorBlending.blendConstants[3] = 0.0f;
+	//Framebuffer blend constants
+	VkPipelineColorBlendStateCreateInfo colorBlending{};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlending.logicOpEnable = VK_FALSE;
+	colorBlending.logicOp = VK_LOGIC_OP_COPY;
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+	colorBlending.blendConstants[0] = 0.0f;
+	colorBlending.blendConstants[1] = 0.0f;
+	colorBlending.blendConstants[2] = 0.0f;
+	colorBlending.blendConstants[3] = 0.0f;
+
+	//Create the graphics pipeline
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = shaderStages;
+
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.pDynamicState = &dynamicState;
+
+	pipelineInfo.layout = mPipelineLayout;
+
+	//With dynamic rendering the pipeline carries the attachment
+	//formats instead of pointing at a render pass object
+	VkPipelineRenderingCreateInfoKHR renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	renderingInfo.colorAttachmentCount = 1;
+	renderingInfo.pColorAttachmentFormats = &mSwapChainImageFormat;
+	renderingInfo.depthAttachmentFormat = mDepthFormat;
+
+	if (mDynamicRenderingActive)
+	{
+		pipelineInfo.pNext = &renderingInfo;
+		pipelineInfo.renderPass = VK_NULL_HANDLE;
+	} else
+	{
+		pipelineInfo.renderPass = mRenderPass;
+	}
+
+	pipelineInfo.subpass = 0;
+
+	//Variants derive from the base pipeline so the driver can share
+	//compiled state; the base itself allows derivatives
+	if (basePipeline != VK_NULL_HANDLE)
+	{
+		pipelineInfo.flags = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+		pipelineInfo.basePipelineHandle = basePipeline;
+	} else
+	{
+		pipelineInfo.flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	}
+	pipelineInfo.basePipelineIndex = -1;
+
+	VkPipeline pipeline;
+	if (vkCreateGraphicsPipelines(mDevice, cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create Graphics Pipeline!\n");
+	}
+
+	//The shader modules stay alive in the cache for the next build
+
+	return pipeline;
+}
+
+/// <summary>
+/// Compiles the given variants in parallel, one worker-local pipeline
+/// cache each, then merges the caches into the main one so the work
+/// lands in the on-disk cache too
+/// </summary>
+/// <param name="keys"></param>
+void VulkanRenderer::compilePipelineVariants(const std::vector<PipelineKey>& keys)
+{
+	std::vector<VkPipelineCache> workerCaches(keys.size());
+	std::vector<VkPipeline> pipelines(keys.size());
+
+	tf::Taskflow taskflow;
+
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		taskflow.emplace([this, &workerCaches, &pipelines, &keys, i]()
+		{
+			//Distinct caches keep vkCreateGraphicsPipelines calls
+			//safely concurrent
+			VkPipelineCacheCreateInfo cacheInfo{};
+			cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+			vkCreatePipelineCache(mDevice, &cacheInfo, nullptr, &workerCaches[i]);
+
+			pipelines[i] = buildGraphicsPipeline(keys[i],
+				workerCaches[i], mGraphicsPipeline);
+		});
+	}
+
+	mExecutor.run(taskflow).wait();
+
+	std::lock_guard<std::mutex> lock(mPipelineLibraryMutex);
+
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		auto existing = mPipelineVariants.find(keys[i]);
+		if (existing != mPipelineVariants.end() && existing->second != VK_NULL_HANDLE)
+		{
+			//Already compiled by an earlier request; drop the duplicate
+			vkDestroyPipeline(mDevice, pipelines[i], nullptr);
+		} else
+		{
+			mPipelineVariants[keys[i]] = pipelines[i];
+		}
+
+		vkMergePipelineCaches(mDevice, mPipelineCache, 1, &workerCaches[i]);
+		vkDestroyPipelineCache(mDevice, workerCaches[i], nullptr);
+	}
+}
+
+/// <summary>
+/// Looks up a variant in the pipeline library; a miss starts an async
+/// compile on the worker pool and returns the base pipeline so the
+/// caller never stalls the frame
+/// </summary>
+/// <param name="key"></param>
+/// <returns></returns>
+VkPipeline VulkanRenderer::getPipeline(const PipelineKey& key)
+{
+	if (key == PipelineKey{})
+	{
+		return mGraphicsPipeline;
+	}
+
+	std::lock_guard<std::mutex> lock(mPipelineLibraryMutex);
+
+	auto found = mPipelineVariants.find(key);
+	if (found != mPipelineVariants.end())
+	{
+		//VK_NULL_HANDLE means the compile is still in flight
+		return found->second != VK_NULL_HANDLE ? found->second : mGraphicsPipeline;
+	}
+
+	//Reserve the slot so the compile only starts once
+	mPipelineVariants[key] = VK_NULL_HANDLE;
+
+	mExecutor.silent_async([this, key]()
+	{
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		VkPipelineCache workerCache;
+		vkCreatePipelineCache(mDevice, &cacheInfo, nullptr, &workerCache);
+
+		VkPipeline pipeline = buildGraphicsPipeline(key, workerCache, mGraphicsPipeline);
+
+		std::lock_guard<std::mutex> lock(mPipelineLibraryMutex);
+		mPipelineVariants[key] = pipeline;
+		vkMergePipelineCaches(mDevice, mPipelineCache, 1, &workerCache);
+		vkDestroyPipelineCache(mDevice, workerCache, nullptr);
+	});
+
+	return mGraphicsPipeline;
+}
+
+/// <summary>
+/// Initializes framebuffers using the swap chains formats and settings
+/// </summary>
+void VulkanRenderer::createFramebuffers()
+{
+	//Resize to hold all framebuffers
+	mSwapChainFramebuffers.resize(mSwapChainImageViews.size());
+
+	//Create framebuffers from image views; the depth attachment is
+	//shared since only one frame renders into it at a time
+	for (size_t i = 0; i < mSwapChainImageViews.size(); i++)
+	{
+		std::array<VkImageView, 2> attachments = {
+			mSwapChainImageViews[i],
+			mDepthImageView
+		};
+
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = mRenderPass;
+		framebufferInfo.attachmentCount = (uint32_t)attachments.size();
+		framebufferInfo.pAttachments = attachments.data();
+		framebufferInfo.width = mSwapChainExtent.width;
+		framebufferInfo.height = mSwapChainExtent.height;
+		framebufferInfo.layers = 1;
+
+		if (vkCreateFramebuffer(mDevice, &framebufferInfo, nullptr, &mSwapChainFramebuffers[i]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("ERROR: Failed to create framebuffer\n");
+		}
+	}
+}
+
+/// <summary>
+/// Creates a command pool using queue family indices
+/// </summary>
+void VulkanRenderer::createCommandPool()
+{
+	QueueFamilyIndices queueFamilyIndices = findQueueFamilies(mPhysicalDevice);
+
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+	if (vkCreateCommandPool(mDevice, &poolInfo, nullptr, &mCommandPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create command pool!\n");
+	}
+}
+
+/// <summary>
+/// Creates one command pool per worker thread so secondary command
+/// buffers can be recorded in parallel without pool contention
+/// </summary>
+void VulkanRenderer::createWorkerCommandPools()
+{
+	mWorkerCount = std::max(1u, std::thread::hardware_concurrency());
+
+	QueueFamilyIndices queueFamilyIndices = findQueueFamilies(mPhysicalDevice);
+
+	mWorkerCommandPools.resize(mWorkerCount);
+
+	for (uint32_t i = 0; i < mWorkerCount; i++)
+	{
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+		if (vkCreateCommandPool(mDevice, &poolInfo, nullptr, &mWorkerCommandPools[i]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("ERROR: Failed to create worker command pool!\n");
+		}
+	}
+}
+
+/// <summary>
+/// Creates the transfer command pool, the ring of fence-tracked
+/// staging slots, and the per-frame command buffers that acquire
+/// queue ownership of streamed data
+/// </summary>
+void VulkanRenderer::createStreamingResources()
+{
+	QueueFamilyIndices indices = findQueueFamilies(mPhysicalDevice);
+
+	//Cached for the ownership-transfer barriers
+	mGraphicsFamilyIndex = indices.graphicsFamily.value();
+	mTransferFamilyIndex = indices.transferFamily.value();
+
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = mTransferFamilyIndex;
+
+	if (vkCreateCommandPool(mDevice, &poolInfo, nullptr, &mTransferCommandPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create transfer command pool!\n");
+	}
+
+	mStreamingSlots.resize(STREAMING_SLOT_COUNT);
+
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for (auto& slot: mStreamingSlots)
+	{
+		createBuffer(STREAMING_SLOT_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			slot.stagingBuffer, slot.stagingAllocation);
+		slot.mapped = mAllocator.map(slot.stagingAllocation);
+		slot.capacity = STREAMING_SLOT_SIZE;
+
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = mTransferCommandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(mDevice, &allocateInfo, &slot.commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("ERROR: Failed to create streaming command buffer!\n");
+		}
+
+		if (vkCreateFence(mDevice, &fenceInfo, nullptr, &slot.fence) != VK_SUCCESS ||
+		    vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &slot.copyComplete) != VK_SUCCESS)
+		{
+			throw std::runtime_error("ERROR: Failed to create streaming sync objects!\n");
+		}
+	}
+
+	//Acquire barriers are re-recorded each frame, so every frame in
+	//flight gets its own small command buffer on the graphics pool
+	mAcquireCommandBuffers.resize(mMaxFramesInFlight);
+
+	VkCommandBufferAllocateInfo acquireInfo{};
+	acquireInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	acquireInfo.commandPool = mCommandPool;
+	acquireInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	acquireInfo.commandBufferCount = (uint32_t)mAcquireCommandBuffers.size();
+
+	if (vkAllocateCommandBuffers(mDevice, &acquireInfo, mAcquireCommandBuffers.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create acquire command buffers!\n");
+	}
+}
+
+/// <summary>
+/// Finds a streaming slot that is safe to reuse, growing its staging
+/// buffer when the upload doesn't fit; returns STREAMING_SLOT_COUNT
+/// when every slot is still busy
+/// </summary>
+/// <param name="size"></param>
+/// <returns></returns>
+uint32_t VulkanRenderer::acquireStreamingSlot(VkDeviceSize size)
+{
+	for (uint32_t attempt = 0; attempt < STREAMING_SLOT_COUNT; attempt++)
+	{
+		uint32_t slotIndex = (mNextStreamingSlot + attempt) % STREAMING_SLOT_COUNT;
+		StreamingSlot& slot = mStreamingSlots[slotIndex];
+
+		//The semaphore can't be re-signaled until the graphics
+		//submit that waited on it has fully retired
+		if (slot.semaphorePending ||
+		    (slot.waitedAtFrame > 0 && mFrameNumber < slot.waitedAtFrame + mMaxFramesInFlight))
+		{
+			continue;
+		}
+
+		if (slot.inFlight)
+		{
+			if (vkGetFenceStatus(mDevice, slot.fence) != VK_SUCCESS)
+			{
+				continue;
+			}
+			slot.inFlight = false;
+		}
+
+		if (slot.capacity < size)
+		{
+			vkDestroyBuffer(mDevice, slot.stagingBuffer, nullptr);
+			mAllocator.free(slot.stagingAllocation);
+
+			createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				slot.stagingBuffer, slot.stagingAllocation);
+			slot.mapped = mAllocator.map(slot.stagingAllocation);
+			slot.capacity = size;
+		}
+
+		mNextStreamingSlot = (slotIndex + 1) % STREAMING_SLOT_COUNT;
+		return slotIndex;
+	}
+
+	return STREAMING_SLOT_COUNT;
+}
+
+/// <summary>
+/// Copies data into a destination buffer asynchronously on the
+/// transfer queue; drawFrame takes queue ownership of the range
+/// before the GPU reads it. Falls back to a blocking copy when
+/// every streaming slot is still in flight.
+/// </summary>
+/// <param name="dstBuffer"></param>
+/// <param name="data"></param>
+/// <param name="size"></param>
+/// <param name="dstOffset"></param>
+void VulkanRenderer::streamBufferData(VkBuffer dstBuffer, const void* data,
+	VkDeviceSize size, VkDeviceSize dstOffset)
+{
+	uint32_t slotIndex = acquireStreamingSlot(size);
+
+	//Every slot busy: take the synchronous path rather than
+	//stalling here waiting for a frame to retire
+	if (slotIndex == STREAMING_SLOT_COUNT)
+	{
+		ensureStagingBuffer(size);
+		memcpy(mAllocator.map(mStagingBufferAllocation), data, (size_t)size);
+		copyBuffer(mStagingBuffer, dstBuffer, size, 0, dstOffset);
+		return;
+	}
+
+	StreamingSlot& slot = mStreamingSlots[slotIndex];
+
+	memcpy(slot.mapped, data, (size_t)size);
+
+	vkResetCommandBuffer(slot.commandBuffer, 0);
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(slot.commandBuffer, &beginInfo);
+
+	VkBufferCopy copyRegion{};
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size = size;
+	vkCmdCopyBuffer(slot.commandBuffer, slot.stagingBuffer, dstBuffer, 1, &copyRegion);
+
+	//Release ownership of the written range to the graphics family;
+	//with a shared family this degrades to a plain memory barrier
+	VkBufferMemoryBarrier release{};
+	release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	release.dstAccessMask = 0;
+	release.srcQueueFamilyIndex = mTransferFamilyIndex;
+	release.dstQueueFamilyIndex = mGraphicsFamilyIndex;
+	release.buffer = dstBuffer;
+	release.offset = dstOffset;
+	release.size = size;
+
+	vkCmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &release, 0, nullptr);
+
+	vkEndCommandBuffer(slot.commandBuffer);
+
+	vkResetFences(mDevice, 1, &slot.fence);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &slot.commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &slot.copyComplete;
+
+	if (vkQueueSubmit(mTransferQueue, 1, &submitInfo, slot.fence) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to submit streaming upload!\n");
+	}
+
+	slot.inFlight = true;
+	slot.semaphorePending = true;
+
+	mPendingAcquires.push_back({dstBuffer, dstOffset, size, mTransferFamilyIndex});
+}
+
+/// <summary>
+/// Records the queue-ownership acquire barriers for every buffer
+/// range written on another family since the last frame (streamed
+/// uploads and compute dispatches)
+/// </summary>
+/// <param name="commandBuffer"></param>
+void VulkanRenderer::recordStreamingAcquires(VkCommandBuffer commandBuffer)
+{
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	std::vector<VkBufferMemoryBarrier> acquires{};
+	acquires.reserve(mPendingAcquires.size());
+
+	for (const auto& pending: mPendingAcquires)
+	{
+		VkBufferMemoryBarrier acquire{};
+		acquire.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		acquire.srcAccessMask = 0;
+		acquire.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+			VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		acquire.srcQueueFamilyIndex = pending.srcFamilyIndex;
+		acquire.dstQueueFamilyIndex = mGraphicsFamilyIndex;
+		acquire.buffer = pending.buffer;
+		acquire.offset = pending.offset;
+		acquire.size = pending.size;
+		acquires.push_back(acquire);
+	}
+
+	//The barrier also orders every later submit on this queue, so
+	//the pre-recorded draw command buffers are covered too
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+		0, 0, nullptr, (uint32_t)acquires.size(), acquires.data(), 0, nullptr);
+
+	vkEndCommandBuffer(commandBuffer);
+
+	mPendingAcquires.clear();
+}
+
+/// <summary>
+/// Creates command buffers using the command pool
+/// </summary>
+void VulkanRenderer::createCommandBuffers()
+{
+	//One command buffer per swap-chain image so recorded
+	//commands can be reused across frames
+	mCommandBuffers.resize(mSwapChainImages.size());
+
+	VkCommandBufferAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = mCommandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = (uint32_t) mCommandBuffers.size();
+
+	if (vkAllocateCommandBuffers(mDevice, &allocateInfo, mCommandBuffers.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create command buffers!\n");
+	}
+
+	//One secondary buffer per worker per swap-chain image,
+	//allocated from that worker's own pool
+	mSecondaryCommandBuffers.resize(mCommandBuffers.size());
+
+	for (size_t image = 0; image < mSecondaryCommandBuffers.size(); image++)
+	{
+		mSecondaryCommandBuffers[image].resize(mWorkerCount);
+
+		for (uint32_t worker = 0; worker < mWorkerCount; worker++)
+		{
+			VkCommandBufferAllocateInfo secondaryInfo{};
+			secondaryInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			secondaryInfo.commandPool = mWorkerCommandPools[worker];
+			secondaryInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			secondaryInfo.commandBufferCount = 1;
+
+			if (vkAllocateCommandBuffers(mDevice, &secondaryInfo,
+				&mSecondaryCommandBuffers[image][worker]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("ERROR: Failed to create secondary command buffers!\n");
+			}
+		}
+	}
+
+	//Everything starts dirty and is recorded on first use
+	markCommandBuffersDirty();
+}
+
+/// <summary>
+/// Flags every pre-recorded command buffer for re-recording
+/// </summary>
+void VulkanRenderer::markCommandBuffersDirty()
+{
+	mCommandBufferDirty.assign(mCommandBuffers.size(), true);
+}
+
+/// <summary>
+/// Starts recording the command buffer and the render pass
+/// </summary>
+/// <param name="commandBuffer"></param>
+/// <param name="imageIndex"></param>
+void VulkanRenderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+	//Begin recording command buffer
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+	//Persistent buffers can be pending for one frame
+	//while being submitted for the next
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+	beginInfo.pInheritanceInfo = nullptr;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to begin recording command buffer!\n");
+	}
+
+	//Clear values match the attachment order in both paths
+	std::array<VkClearValue, 2> clearValues{};
+	clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+	clearValues[1].depthStencil = {1.0f, 0};
+
+	//Bracket the render pass with timestamps; the reset must
+	//happen outside the pass
+	if (mTimestampsSupported)
+	{
+		vkCmdResetQueryPool(commandBuffer, mTimestampQueryPool, imageIndex * 2, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			mTimestampQueryPool, imageIndex * 2);
+	}
+
+	//Counter queries bracket the render pass; an imprecise occlusion
+	//query is enough to compare visible samples against fragment work
+	if (mGpuCountersActive)
+	{
+		vkCmdResetQueryPool(commandBuffer, mPipelineStatsQueryPool, imageIndex, 1);
+		vkCmdResetQueryPool(commandBuffer, mOcclusionQueryPool, imageIndex, 1);
+		vkCmdBeginQuery(commandBuffer, mPipelineStatsQueryPool, imageIndex, 0);
+		vkCmdBeginQuery(commandBuffer, mOcclusionQueryPool, imageIndex, 0);
+	}
+
+	//Mark the pass so captures show it as a named region
+	beginCommandLabel(commandBuffer, "Main render pass");
+
+	if (mDynamicRenderingActive)
+	{
+		//Dynamic rendering does no implicit layout transitions; move
+		//both targets into attachment layout ourselves (contents are
+		//cleared, so whatever layout they were in can be discarded)
+		std::array<VkImageMemoryBarrier, 2> attachmentBarriers{};
+
+		attachmentBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		attachmentBarriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachmentBarriers[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachmentBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		attachmentBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		attachmentBarriers[0].image = mSwapChainImages[imageIndex];
+		attachmentBarriers[0].srcAccessMask = 0;
+		attachmentBarriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		attachmentBarriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		attachmentBarriers[0].subresourceRange.levelCount = 1;
+		attachmentBarriers[0].subresourceRange.layerCount = 1;
+
+		bool hasStencil = mDepthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT ||
+			mDepthFormat == VK_FORMAT_D24_UNORM_S8_UINT;
+
+		attachmentBarriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		attachmentBarriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachmentBarriers[1].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		attachmentBarriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		attachmentBarriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		attachmentBarriers[1].image = mDepthImage;
+		attachmentBarriers[1].srcAccessMask = 0;
+		attachmentBarriers[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		attachmentBarriers[1].subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT |
+			(hasStencil ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+		attachmentBarriers[1].subresourceRange.levelCount = 1;
+		attachmentBarriers[1].subresourceRange.layerCount = 1;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+			0, 0, nullptr, 0, nullptr,
+			(uint32_t)attachmentBarriers.size(), attachmentBarriers.data());
+
+		VkRenderingAttachmentInfoKHR colorAttachment{};
+		colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		colorAttachment.imageView = mSwapChainImageViews[imageIndex];
+		colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.clearValue = clearValues[0];
+
+		VkRenderingAttachmentInfoKHR depthAttachment{};
+		depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		depthAttachment.imageView = mDepthImageView;
+		depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.clearValue = clearValues[1];
+
+		VkRenderingInfoKHR renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+		renderingInfo.renderArea.offset = {0, 0};
+		renderingInfo.renderArea.extent = mSwapChainExtent;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = 1;
+		renderingInfo.pColorAttachments = &colorAttachment;
+		renderingInfo.pDepthAttachment = &depthAttachment;
+
+		mCmdBeginRenderingKHR(commandBuffer, &renderingInfo);
+	} else
+	{
+		//Start render pass
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = mRenderPass;
+		renderPassInfo.framebuffer = mSwapChainFramebuffers[imageIndex];
+
+		renderPassInfo.renderArea.offset = {0, 0};
+		renderPassInfo.renderArea.extent = mSwapChainExtent;
+
+		renderPassInfo.clearValueCount = (uint32_t)clearValues.size();
+		renderPassInfo.pClearValues = clearValues.data();
+
+		//Draw commands live in secondary buffers recorded by the workers
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo,
+			VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	}
+
+	//One job per worker, capped by how many draws there are to split up
+	uint32_t jobCount = getRecordJobCount();
+
+	//Fan recording out across the worker pool
+	tf::Taskflow taskflow;
+	for (uint32_t worker = 0; worker < jobCount; worker++)
+	{
+		taskflow.emplace([this, imageIndex, worker]
+		{
+			recordSecondaryCommandBuffer(mSecondaryCommandBuffers[imageIndex][worker],
+				imageIndex, worker);
+		});
+	}
+	mExecutor.run(taskflow).wait();
+
+	vkCmdExecuteCommands(commandBuffer, jobCount, mSecondaryCommandBuffers[imageIndex].data());
+
+	if (mDynamicRenderingActive)
+	{
+		mCmdEndRenderingKHR(commandBuffer);
+
+		//Hand the image to presentation (or readback when headless);
+		//the render pass used to do this transition implicitly
+		VkImageMemoryBarrier presentBarrier{};
+		presentBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		presentBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		presentBarrier.newLayout = mHeadless ?
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		presentBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		presentBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		presentBarrier.image = mSwapChainImages[imageIndex];
+		presentBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		presentBarrier.dstAccessMask = mHeadless ? VK_ACCESS_TRANSFER_READ_BIT : 0;
+		presentBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		presentBarrier.subresourceRange.levelCount = 1;
+		presentBarrier.subresourceRange.layerCount = 1;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			mHeadless ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &presentBarrier);
+	} else
+	{
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	endCommandLabel(commandBuffer);
+
+	if (mGpuCountersActive)
+	{
+		vkCmdEndQuery(commandBuffer, mPipelineStatsQueryPool, imageIndex);
+		vkCmdEndQuery(commandBuffer, mOcclusionQueryPool, imageIndex);
+	}
+
+	if (mTimestampsSupported)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			mTimestampQueryPool, imageIndex * 2 + 1);
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to record command buffer!\n");
+	}
+}
+
+/// <summary>
+/// Records one worker's slice of the frame's draw calls
+/// into a secondary command buffer
+/// </summary>
+/// <param name="commandBuffer"></param>
+/// <param name="imageIndex"></param>
+/// <param name="workerIndex"></param>
+void VulkanRenderer::recordSecondaryCommandBuffer(VkCommandBuffer commandBuffer,
+	uint32_t imageIndex, uint32_t workerIndex)
+{
+	vkResetCommandBuffer(commandBuffer, 0);
+
+	//Secondaries executed inside a render pass must inherit it; with
+	//dynamic rendering they inherit the attachment formats instead
+	VkCommandBufferInheritanceRenderingInfoKHR inheritanceRenderingInfo{};
+	inheritanceRenderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+	inheritanceRenderingInfo.colorAttachmentCount = 1;
+	inheritanceRenderingInfo.pColorAttachmentFormats = &mSwapChainImageFormat;
+	inheritanceRenderingInfo.depthAttachmentFormat = mDepthFormat;
+	inheritanceRenderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkCommandBufferInheritanceInfo inheritanceInfo{};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+
+	if (mDynamicRenderingActive)
+	{
+		inheritanceInfo.pNext = &inheritanceRenderingInfo;
+	} else
+	{
+		inheritanceInfo.renderPass = mRenderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = mSwapChainFramebuffers[imageIndex];
+	}
+
+	//Counter queries active in the primary keep counting in here
+	//(requires the inheritedQueries feature, checked at device creation)
+	if (mGpuCountersActive)
+	{
+		inheritanceInfo.occlusionQueryEnable = VK_TRUE;
+		inheritanceInfo.pipelineStatistics = PIPELINE_STATS_FLAGS;
+	}
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+		VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to begin recording secondary command buffer!\n");
+	}
+
+	//Bind the graphics pipeline (VK_PIPELINE_BIND_POINT_COMPUTE for compute pipelines)
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
+
+	//Specify our dynamic pipeline values here
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = (float) mSwapChainExtent.width;
+	viewport.height = (float) mSwapChainExtent.height;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	//Update our viewport
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor{};
+	scissor.offset = {0, 0};
+	scissor.extent = mSwapChainExtent;
+
+	//Update our scissor
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	//Bind both vertex streams: positions at 0, shading attributes at 1
+	VkBuffer vertexBuffers[] = {mPositionBuffer, mAttributeBuffer};
+	VkDeviceSize offsets[] = {0, 0};
+	vkCmdBindVertexBuffers(commandBuffer,
+		0, 2, vertexBuffers, offsets);
+
+	vkCmdBindIndexBuffer(commandBuffer,
+		mIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+	//Bind this image's uniform buffer
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+		mPipelineLayout, 0, 1, &mDescriptorSets[imageIndex], 0, nullptr);
+
+	uint32_t drawCount = (uint32_t)mMeshes.size();
+
+	if (mIndirectDrawEnabled)
+	{
+		//Every draw's parameters live on the GPU; command-buffer cost
+		//no longer scales with mesh count
+		if (mMultiDrawIndirectSupported)
+		{
+			vkCmdDrawIndexedIndirect(commandBuffer, mIndirectBuffer, 0,
+				drawCount, sizeof(VkDrawIndexedIndirectCommand));
+		} else
+		{
+			//Without multiDrawIndirect each call may only consume one command
+			for (uint32_t i = 0; i < drawCount; i++)
+			{
+				vkCmdDrawIndexedIndirect(commandBuffer, mIndirectBuffer,
+					i * sizeof(VkDrawIndexedIndirectCommand), 1,
+					sizeof(VkDrawIndexedIndirectCommand));
+			}
+		}
+	} else
+	{
+		//Draw this worker's contiguous slice of the registered meshes;
+		//the shared buffers above are bound exactly once
+		uint32_t jobCount = getRecordJobCount();
+		uint32_t meshesPerWorker = (drawCount + jobCount - 1) / jobCount;
+		uint32_t firstMesh = workerIndex * meshesPerWorker;
+		uint32_t lastMesh = std::min(drawCount, firstMesh + meshesPerWorker);
+
+		for (uint32_t i = firstMesh; i < lastMesh; i++)
+		{
+			const MeshDraw& mesh = mMeshes[i];
+			vkCmdDrawIndexed(commandBuffer, mesh.indexCount, 1,
+				mesh.firstIndex, mesh.vertexOffset, 0);
+		}
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to record secondary command buffer!\n");
+	}
+}
+
+/// <summary>
+/// Records one extra window's frame: the same scene and pipeline as
+/// the primary window, drawn inline into that window's attachments
+/// </summary>
+/// <param name="windowSurface"></param>
+/// <param name="imageIndex"></param>
+/// <param name="uniformIndex"></param>
+void VulkanRenderer::recordExtraWindowCommands(WindowSurface& windowSurface,
+	uint32_t imageIndex, uint32_t uniformIndex)
+{
+	VkCommandBuffer commandBuffer = windowSurface.commandBuffers[mCurrentFrame];
+	vkResetCommandBuffer(commandBuffer, 0);
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+	//Re-recorded every frame, never pending across submits
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to begin recording command buffer!\n");
+	}
+
+	std::array<VkClearValue, 2> clearValues{};
+	clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+	clearValues[1].depthStencil = {1.0f, 0};
+
+	if (mDynamicRenderingActive)
+	{
+		//Same manual transitions the primary chain needs: dynamic
+		//rendering does no implicit layout changes
+		std::array<VkImageMemoryBarrier, 2> attachmentBarriers{};
+
+		attachmentBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		attachmentBarriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachmentBarriers[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachmentBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		attachmentBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		attachmentBarriers[0].image = windowSurface.images[imageIndex];
+		attachmentBarriers[0].srcAccessMask = 0;
+		attachmentBarriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		attachmentBarriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		attachmentBarriers[0].subresourceRange.levelCount = 1;
+		attachmentBarriers[0].subresourceRange.layerCount = 1;
+
+		bool hasStencil = mDepthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT ||
+			mDepthFormat == VK_FORMAT_D24_UNORM_S8_UINT;
+
+		attachmentBarriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		attachmentBarriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachmentBarriers[1].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		attachmentBarriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		attachmentBarriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		attachmentBarriers[1].image = windowSurface.depthImage;
+		attachmentBarriers[1].srcAccessMask = 0;
+		attachmentBarriers[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		attachmentBarriers[1].subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT |
+			(hasStencil ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+		attachmentBarriers[1].subresourceRange.levelCount = 1;
+		attachmentBarriers[1].subresourceRange.layerCount = 1;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+			0, 0, nullptr, 0, nullptr,
+			(uint32_t)attachmentBarriers.size(), attachmentBarriers.data());
+
+		VkRenderingAttachmentInfoKHR colorAttachment{};
+		colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		colorAttachment.imageView = windowSurface.imageViews[imageIndex];
+		colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.clearValue = clearValues[0];
+
+		VkRenderingAttachmentInfoKHR depthAttachment{};
+		depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		depthAttachment.imageView = windowSurface.depthImageView;
+		depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.clearValue = clearValues[1];
+
+		VkRenderingInfoKHR renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		renderingInfo.renderArea.offset = {0, 0};
+		renderingInfo.renderArea.extent = windowSurface.extent;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = 1;
+		renderingInfo.pColorAttachments = &colorAttachment;
+		renderingInfo.pDepthAttachment = &depthAttachment;
+
+		mCmdBeginRenderingKHR(commandBuffer, &renderingInfo);
+	} else
+	{
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = mRenderPass;
+		renderPassInfo.framebuffer = windowSurface.framebuffers[imageIndex];
+
+		renderPassInfo.renderArea.offset = {0, 0};
+		renderPassInfo.renderArea.extent = windowSurface.extent;
+
+		renderPassInfo.clearValueCount = (uint32_t)clearValues.size();
+		renderPassInfo.pClearValues = clearValues.data();
+
+		//Draws are recorded inline; one window's worth of commands
+		//doesn't warrant the worker fan-out
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
+
+	//Viewport and scissor are dynamic state, which is what lets the
+	//shared pipelines drive windows of different sizes
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = (float) windowSurface.extent.width;
+	viewport.height = (float) windowSurface.extent.height;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor{};
+	scissor.offset = {0, 0};
+	scissor.extent = windowSurface.extent;
+
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	//Bind both vertex streams: positions at 0, shading attributes at 1
+	VkBuffer vertexBuffers[] = {mPositionBuffer, mAttributeBuffer};
+	VkDeviceSize offsets[] = {0, 0};
+	vkCmdBindVertexBuffers(commandBuffer,
+		0, 2, vertexBuffers, offsets);
+
+	vkCmdBindIndexBuffer(commandBuffer,
+		mIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+	//The uniform ring is indexed by the primary chain's image, which
+	//is what this frame's updateUniformBuffer wrote
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+		mPipelineLayout, 0, 1, &mDescriptorSets[uniformIndex], 0, nullptr);
+
+	uint32_t drawCount = (uint32_t)mMeshes.size();
+
+	if (mIndirectDrawEnabled && mMultiDrawIndirectSupported)
+	{
+		vkCmdDrawIndexedIndirect(commandBuffer, mIndirectBuffer, 0,
+			drawCount, sizeof(VkDrawIndexedIndirectCommand));
+	} else
+	{
+		for (uint32_t i = 0; i < drawCount; i++)
+		{
+			const MeshDraw& mesh = mMeshes[i];
+			vkCmdDrawIndexed(commandBuffer, mesh.indexCount, 1,
+				mesh.firstIndex, mesh.vertexOffset, 0);
+		}
+	}
+
+	if (mDynamicRenderingActive)
+	{
+		mCmdEndRenderingKHR(commandBuffer);
+
+		//Hand the image to presentation, as the render pass would
+		VkImageMemoryBarrier presentBarrier{};
+		presentBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		presentBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		presentBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		presentBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		presentBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		presentBarrier.image = windowSurface.images[imageIndex];
+		presentBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		presentBarrier.dstAccessMask = 0;
+		presentBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		presentBarrier.subresourceRange.levelCount = 1;
+		presentBarrier.subresourceRange.layerCount = 1;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &presentBarrier);
+	} else
+	{
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to record command buffer!\n");
+	}
+}
+
+/// <summary>
+/// Creates Semaphores and fences that are used to keep the CPU and GPU in sync
+/// </summary>
+void VulkanRenderer::createSyncObjects()
+{
+	//More frames in flight than swap-chain images can't overlap
+	mMaxFramesInFlight = std::clamp(mMaxFramesInFlight, 1u,
+		(uint32_t)mSwapChainImages.size());
+
+	mImageAvailableSemaphore.resize(mMaxFramesInFlight);
+	mInFlightFence.resize(mMaxFramesInFlight);
+
+	//Render-finished semaphores belong to the images they signal for
+	mRenderFinishedSemaphore.resize(mSwapChainImages.size());
+	mImagesInFlight.assign(mSwapChainImages.size(), VK_NULL_HANDLE);
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	for (size_t i = 0; i < mMaxFramesInFlight; i++)
+	{
+		if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &mImageAvailableSemaphore[i]) != VK_SUCCESS ||
+		    vkCreateFence(mDevice, &fenceInfo, nullptr, &mInFlightFence[i]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("ERROR: Failed to create synchronization objects!\n");
+		}
+	}
+
+	for (size_t i = 0; i < mRenderFinishedSemaphore.size(); i++)
+	{
+		if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &mRenderFinishedSemaphore[i]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("ERROR: Failed to create synchronization objects!\n");
+		}
+	}
+}
+
+/// <summary>
+/// Sets how many frames the CPU may record ahead of the GPU; must be
+/// called before init so every per-frame resource is sized to match
+/// </summary>
+/// <param name="frames"></param>
+void VulkanRenderer::setMaxFramesInFlight(uint32_t frames)
+{
+	if (mDevice != VK_NULL_HANDLE)
+	{
+		throw std::runtime_error("ERROR: setMaxFramesInFlight must be called before init!\n");
+	}
+
+	mMaxFramesInFlight = std::max(1u, frames);
+}
+
+/// <summary>
+/// Opts in or out of the VK_KHR_dynamic_rendering path; must be
+/// called before init (unsupported devices fall back regardless)
+/// </summary>
+/// <param name="enabled"></param>
+void VulkanRenderer::setDynamicRenderingEnabled(bool enabled)
+{
+	if (mDevice != VK_NULL_HANDLE)
+	{
+		throw std::runtime_error("ERROR: setDynamicRenderingEnabled must be called before init!\n");
+	}
+
+	mDynamicRenderingEnabled = enabled;
+}
+
+/// <summary>
+/// Pins device selection to an enumeration index (as reported by
+/// enumerateDevices); must be called before init
+/// </summary>
+/// <param name="index"></param>
+void VulkanRenderer::setPreferredDeviceIndex(uint32_t index)
+{
+	if (mDevice != VK_NULL_HANDLE)
+	{
+		throw std::runtime_error("ERROR: setPreferredDeviceIndex must be called before init!\n");
+	}
+
+	mPreferredDeviceIndex = index;
+}
+
+/// <summary>
+/// Pins device selection to a deviceUUID, which survives enumeration
+/// order changes across driver updates; must be called before init
+/// </summary>
+/// <param name="uuid"></param>
+void VulkanRenderer::setPreferredDeviceUuid(const std::array<uint8_t, VK_UUID_SIZE>& uuid)
+{
+	if (mDevice != VK_NULL_HANDLE)
+	{
+		throw std::runtime_error("ERROR: setPreferredDeviceUuid must be called before init!\n");
+	}
+
+	mPreferredDeviceUuid = uuid;
+}
+
+/// <summary>
+/// Installs an application scoring callback that replaces the built-in
+/// heuristic (the mandatory checks still gate suitability); must be
+/// called before init
+/// </summary>
+/// <param name="callback"></param>
+void VulkanRenderer::setDeviceScoringCallback(DeviceScoringCallback callback)
+{
+	if (mDevice != VK_NULL_HANDLE)
+	{
+		throw std::runtime_error("ERROR: setDeviceScoringCallback must be called before init!\n");
+	}
+
+	mDeviceScoringCallback = callback;
+}
+
+/// <summary>
+/// Sets the present mode the swap chain should ask for; FIFO is the
+/// guaranteed fallback when the surface doesn't offer it. Changing
+/// the mode mid-run takes effect by recreating the swap chain
+/// </summary>
+/// <param name="mode"></param>
+void VulkanRenderer::setPresentMode(VkPresentModeKHR mode)
+{
+	mPreferredPresentMode = mode;
+
+	if (mDevice != VK_NULL_HANDLE)
+	{
+		requestSwapChainRecreate();
+	}
+}
+
+/// <summary>
+/// Sets how many images to request beyond the surface's minimum;
+/// more images smooth presentation, fewer cut latency (the surface's
+/// maximum still clamps the total)
+/// </summary>
+/// <param name="extraImages"></param>
+void VulkanRenderer::setSwapChainImageMargin(uint32_t extraImages)
+{
+	mSwapChainImageMargin = extraImages;
+
+	if (mDevice != VK_NULL_HANDLE)
+	{
+		requestSwapChainRecreate();
+	}
+}
+
+/// <summary>
+/// Enables the late-latch wait at the end of drawFrame, trading
+/// frame overlap for input-to-photon latency
+/// </summary>
+/// <param name="enabled"></param>
+void VulkanRenderer::setLatencyWaitEnabled(bool enabled)
+{
+	mLatencyWaitEnabled = enabled;
+}
+
+/// <summary>
+/// Caps the main loop at a target frame rate through the pacing
+/// governor (0 removes the cap); safe to change mid-run, the
+/// deadline chain simply restarts
+/// </summary>
+/// <param name="fps"></param>
+void VulkanRenderer::setTargetFps(double fps)
+{
+	mTargetFrameSeconds = fps > 0.0 ? 1.0 / fps : 0.0;
+	mNextFrameDeadline = {};
+}
+
+/// <summary>
+/// Idles the main loop in glfwWaitEventsTimeout while no window has
+/// focus, rendering at the background rate instead of full tilt
+/// </summary>
+/// <param name="enabled"></param>
+/// <param name="backgroundFps"></param>
+void VulkanRenderer::setIdleWhenUnfocused(bool enabled, double backgroundFps)
+{
+	mIdleWhenUnfocused = enabled;
+	mBackgroundFrameSeconds = backgroundFps > 0.0 ? 1.0 / backgroundFps : 0.1;
+}
+
+/// <summary>
+/// Opts into the GPU counter query mode; must be called before init
+/// so the device features can be enabled (devices without them fall
+/// back to timestamps only)
+/// </summary>
+/// <param name="enabled"></param>
+void VulkanRenderer::setGpuCountersEnabled(bool enabled)
+{
+	if (mDevice != VK_NULL_HANDLE)
+	{
+		throw std::runtime_error("ERROR: setGpuCountersEnabled must be called before init!\n");
+	}
+
+	mGpuCountersEnabled = enabled;
+}
+
+/// <summary>
+/// Hooks an external CPU profiler into drawFrame; the callbacks fire
+/// around each stage (acquire, record, submit, present) in debug
+/// builds and are never invoked in release builds
+/// </summary>
+/// <param name="beginZone"></param>
+/// <param name="endZone"></param>
+void VulkanRenderer::setProfilerCallbacks(ProfilerZoneCallback beginZone,
+	ProfilerZoneCallback endZone)
+{
+	mProfilerBeginZone = beginZone;
+	mProfilerEndZone = endZone;
+}
+
+/// <summary>
+/// Registers another window to open at init, rendered from the same
+/// device, pipelines, and scene as the primary one
+/// </summary>
+/// <param name="width"></param>
+/// <param name="height"></param>
+/// <param name="title"></param>
+void VulkanRenderer::addWindow(uint32_t width, uint32_t height, const std::string& title)
+{
+	if (mDevice != VK_NULL_HANDLE)
+	{
+		throw std::runtime_error("ERROR: addWindow must be called before init!\n");
+	}
+
+	if (mHeadless)
+	{
+		throw std::runtime_error("ERROR: addWindow is not available headless!\n");
+	}
+
+	WindowSurface windowSurface{};
+	windowSurface.width = width;
+	windowSurface.height = height;
+	windowSurface.title = title;
+	mExtraWindows.push_back(std::move(windowSurface));
+}
+
+/// <summary>
+/// Switches the renderer to offscreen targets with no window, swap
+/// chain, or present; must be called before init
+/// </summary>
+/// <param name="enabled"></param>
+void VulkanRenderer::setHeadless(bool enabled)
+{
+	if (mDevice != VK_NULL_HANDLE)
+	{
+		throw std::runtime_error("ERROR: setHeadless must be called before init!\n");
+	}
+
+	if (enabled && !mExtraWindows.empty())
+	{
+		throw std::runtime_error("ERROR: Headless mode can't drive extra windows!\n");
+	}
+
+	mHeadless = enabled;
+}
+
+/// <summary>
+/// Bounds the headless run loop by frame count and/or wall-clock
+/// seconds; update() returns once either bound is reached
+/// </summary>
+/// <param name="frameCount"></param>
+/// <param name="seconds"></param>
+void VulkanRenderer::setHeadlessRunLimits(uint64_t frameCount, double seconds)
+{
+	mHeadlessFrameLimit = frameCount;
+	mHeadlessDurationLimit = seconds;
+}
+
+/// <summary>
+/// Copies the most recently rendered headless frame into tightly
+/// packed B8G8R8A8 pixels; blocks until the GPU is idle
+/// </summary>
+/// <returns></returns>
+std::vector<uint8_t> VulkanRenderer::readbackHeadlessFrame()
+{
+	if (!mHeadless)
+	{
+		throw std::runtime_error("ERROR: readbackHeadlessFrame requires headless mode!\n");
+	}
+
+	if (mFrameNumber == 0)
+	{
+		throw std::runtime_error("ERROR: No headless frame has been rendered yet!\n");
+	}
+
+	//The last submitted frame must have left its target in
+	//TRANSFER_SRC_OPTIMAL before we copy from it
+	vkDeviceWaitIdle(mDevice);
+
+	uint32_t imageCount = (uint32_t)mSwapChainImages.size();
+	uint32_t imageIndex = (uint32_t)((mFrameNumber - 1) % imageCount);
+
+	VkDeviceSize imageSize = (VkDeviceSize)mSwapChainExtent.width *
+		mSwapChainExtent.height * 4;
+
+	//The shared staging buffer is transfer-source only, so readback
+	//gets a throwaway destination buffer
+	VkBuffer readbackBuffer;
+	GpuAllocation readbackAllocation;
+	createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		readbackBuffer, readbackAllocation);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	VkBufferImageCopy region{};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = {0, 0, 0};
+	region.imageExtent = {mSwapChainExtent.width, mSwapChainExtent.height, 1};
+
+	vkCmdCopyImageToBuffer(commandBuffer, mSwapChainImages[imageIndex],
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+	endSingleTimeCommands(commandBuffer);
+
+	std::vector<uint8_t> pixels((size_t)imageSize);
+	memcpy(pixels.data(), mAllocator.map(readbackAllocation), (size_t)imageSize);
+
+	vkDestroyBuffer(mDevice, readbackBuffer, nullptr);
+	mAllocator.free(readbackAllocation);
+
+	return pixels;
+}
+
+/// <summary>
+/// Forces the next drawFrame to rebuild the swap chain through the
+/// resize path, so benchmarks can exercise recreateSwapChain
+/// </summary>
+void VulkanRenderer::requestSwapChainRecreate()
+{
+	mFramebufferResized = true;
+}
+
+/// <summary>
+/// Blocks until the GPU has finished all submitted work; update()
+/// does this itself, direct drawFrame callers must before cleanup
+/// </summary>
+void VulkanRenderer::waitIdle()
+{
+	vkDeviceWaitIdle(mDevice);
+}
+
+MeshHandle VulkanRenderer::registerMesh(const std::vector<Vertex>& vertices,
+	const std::vector<uint32_t>& indices)
+{
+	MeshDraw mesh{};
+	mesh.indexCount = (uint32_t)indices.size();
+	mesh.firstIndex = (uint32_t)mMeshIndices.size();
+	mesh.vertexOffset = (int32_t)mMeshVertices.size();
+
+	mMeshVertices.insert(mMeshVertices.end(), vertices.begin(), vertices.end());
+	mMeshIndices.insert(mMeshIndices.end(), indices.begin(), indices.end());
+	mMeshes.push_back(mesh);
+
+	//The packed buffers and recorded draws are stale now
+	mMeshBuffersDirty = true;
+	markCommandBuffersDirty();
+
+	return (MeshHandle)(mMeshes.size() - 1);
+}
+
+/// <summary>
+/// Quantizes every registered mesh into the split position and
+/// attribute streams and uploads them plus the shared index buffer
+/// </summary>
+void VulkanRenderer::buildMeshBuffers()
+{
+	if (mMeshVertices.empty() || mMeshIndices.empty())
+	{
+		return;
+	}
+
+	//Retire the live buffers instead of stalling; frames already
+	//submitted keep drawing from them until their fences signal
+	if (mPositionBuffer != VK_NULL_HANDLE)
+	{
+		retireBuffer(mPositionBuffer, mPositionBufferAllocation);
+		retireBuffer(mAttributeBuffer, mAttributeBufferAllocation);
+		retireBuffer(mIndexBuffer, mIndexBufferAllocation);
+	}
+
+	//Quantize into the split streams; a depth-only pass fetches
+	//4 bytes per vertex instead of the full interleaved struct
+	std::vector<PackedPosition> positions;
+	std::vector<PackedShadingAttributes> attributes;
+	positions.reserve(mMeshVertices.size());
+	attributes.reserve(mMeshVertices.size());
+
+	for (const auto& vertex: mMeshVertices)
+	{
+		positions.push_back(packPosition(vertex.position));
+		attributes.push_back(packShadingAttributes(vertex.color, vertex.uv));
+	}
+
+	VkDeviceSize positionSize = sizeof(PackedPosition) * positions.size();
+	VkDeviceSize attributeSize = sizeof(PackedShadingAttributes) * attributes.size();
+	VkDeviceSize indexSize = sizeof(uint32_t) * mMeshIndices.size();
+
+	//Stage both streams and the indices back to back in one upload
+	ensureStagingBuffer(positionSize + attributeSize + indexSize);
+
+	char* data = (char*)mAllocator.map(mStagingBufferAllocation);
+	memcpy(data, positions.data(), (size_t)positionSize);
+	memcpy(data + positionSize, attributes.data(), (size_t)attributeSize);
+	memcpy(data + positionSize + attributeSize, mMeshIndices.data(), (size_t)indexSize);
+
+	//Final storage lives in device-local memory so vertex
+	//fetches never cross the PCIe bus on discrete GPUs
+	createBuffer(positionSize,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		mPositionBuffer, mPositionBufferAllocation);
+
+	createBuffer(attributeSize,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		mAttributeBuffer, mAttributeBufferAllocation);
+
+	createBuffer(indexSize,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		mIndexBuffer, mIndexBufferAllocation);
+
+	copyBuffer(mStagingBuffer, mPositionBuffer, positionSize);
+	copyBuffer(mStagingBuffer, mAttributeBuffer, attributeSize, positionSize);
+	copyBuffer(mStagingBuffer, mIndexBuffer, indexSize, positionSize + attributeSize);
+
+	//Rebuilt buffers get fresh handles, so re-name them for captures
+	setObjectName((uint64_t)mPositionBuffer, VK_OBJECT_TYPE_BUFFER, "Mesh position stream");
+	setObjectName((uint64_t)mAttributeBuffer, VK_OBJECT_TYPE_BUFFER, "Mesh attribute stream");
+	setObjectName((uint64_t)mIndexBuffer, VK_OBJECT_TYPE_BUFFER, "Mesh index buffer");
+
+	buildIndirectBuffer();
+
+	mMeshBuffersDirty = false;
+}
+
+/// <summary>
+/// Uploads one VkDrawIndexedIndirectCommand per registered mesh into a
+/// device-local buffer so the CPU never re-records per-mesh draws
+/// </summary>
+void VulkanRenderer::buildIndirectBuffer()
+{
+	if (mIndirectBuffer != VK_NULL_HANDLE)
+	{
+		//In-flight frames may still source draws from the old buffer
+		retireBuffer(mIndirectBuffer, mIndirectBufferAllocation);
+	}
+
+	std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+	drawCommands.reserve(mMeshes.size());
+
+	for (const auto& mesh: mMeshes)
+	{
+		VkDrawIndexedIndirectCommand drawCommand{};
+		drawCommand.indexCount = mesh.indexCount;
+		drawCommand.instanceCount = 1;
+		drawCommand.firstIndex = mesh.firstIndex;
+		drawCommand.vertexOffset = mesh.vertexOffset;
+		drawCommand.firstInstance = 0;
+		drawCommands.push_back(drawCommand);
+	}
+
+	VkDeviceSize bufferSize = sizeof(VkDrawIndexedIndirectCommand) * drawCommands.size();
+
+	ensureStagingBuffer(bufferSize);
+
+	void* data = mAllocator.map(mStagingBufferAllocation);
+	memcpy(data, drawCommands.data(), (size_t)bufferSize);
+
+	createBuffer(bufferSize,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		mIndirectBuffer, mIndirectBufferAllocation);
+
+	copyBuffer(mStagingBuffer, mIndirectBuffer, bufferSize);
+}
+
+void VulkanRenderer::setIndirectDrawEnabled(bool enabled)
+{
+	if (mIndirectDrawEnabled == enabled)
+	{
+		return;
+	}
+
+	mIndirectDrawEnabled = enabled;
+	markCommandBuffersDirty();
+}
+
+/// <summary>
+/// Builds a compute pipeline around the given SPIR-V shader with a
+/// storage buffer at binding 0, plus the queue-side objects to run it
+/// </summary>
+/// <param name="spvPath"></param>
+/// <param name="storageBufferSize"></param>
+void VulkanRenderer::setupCompute(const std::string& spvPath, VkDeviceSize storageBufferSize)
+{
+	QueueFamilyIndices indices = findQueueFamilies(mPhysicalDevice);
+
+	if (!indices.computeFamily.has_value())
+	{
+		throw std::runtime_error("ERROR: No compute-capable queue family available!\n");
+	}
+
+	//Remembered for the queue-ownership transfer each dispatch needs
+	//when the compute family isn't the graphics family
+	mComputeFamilyIndex = indices.computeFamily.value();
+
+	//Storage buffer the shader reads and writes
+	createBuffer(storageBufferSize,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		mComputeStorageBuffer, mComputeStorageBufferAllocation);
+
+	//Descriptor layout: one storage buffer visible to compute
+	VkDescriptorSetLayoutBinding storageBinding{};
+	storageBinding.binding = 0;
+	storageBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	storageBinding.descriptorCount = 1;
+	storageBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &storageBinding;
+
+	if (vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &mComputeDescriptorSetLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create compute descriptor set layout!\n");
+	}
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = 1;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = 1;
+
+	if (vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &mComputeDescriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create compute descriptor pool!\n");
+	}
+
+	VkDescriptorSetAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = mComputeDescriptorPool;
+	allocateInfo.descriptorSetCount = 1;
+	allocateInfo.pSetLayouts = &mComputeDescriptorSetLayout;
+
+	if (vkAllocateDescriptorSets(mDevice, &allocateInfo, &mComputeDescriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to allocate compute descriptor set!\n");
+	}
+
+	VkDescriptorBufferInfo bufferInfo{};
+	bufferInfo.buffer = mComputeStorageBuffer;
+	bufferInfo.offset = 0;
+	bufferInfo.range = storageBufferSize;
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = mComputeDescriptorSet;
+	descriptorWrite.dstBinding = 0;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pBufferInfo = &bufferInfo;
+
+	vkUpdateDescriptorSets(mDevice, 1, &descriptorWrite, 0, nullptr);
+
+	//Pipeline layout and compute pipeline
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &mComputeDescriptorSetLayout;
+
+	if (vkCreatePipelineLayout(mDevice, &pipelineLayoutInfo, nullptr, &mComputePipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create compute pipeline layout!\n");
+	}
+
+	VkShaderModule computeShaderModule = mShaderManager.getModule(spvPath);
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = computeShaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = mComputePipelineLayout;
+
+	if (vkCreateComputePipelines(mDevice, mPipelineCache, 1, &pipelineInfo, nullptr, &mComputePipeline) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create compute pipeline!\n");
+	}
+
+	//Command pool and buffer on the compute family
+	VkCommandPoolCreateInfo commandPoolInfo{};
+	commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	commandPoolInfo.queueFamilyIndex = indices.computeFamily.value();
+
+	if (vkCreateCommandPool(mDevice, &commandPoolInfo, nullptr, &mComputeCommandPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create compute command pool!\n");
+	}
+
+	VkCommandBufferAllocateInfo commandBufferInfo{};
+	commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	commandBufferInfo.commandPool = mComputeCommandPool;
+	commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandBufferInfo.commandBufferCount = 1;
+
+	if (vkAllocateCommandBuffers(mDevice, &commandBufferInfo, &mComputeCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create compute command buffer!\n");
+	}
+
+	//Sync objects tying dispatches to the graphics submit
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &mComputeFinishedSemaphore) != VK_SUCCESS ||
+	    vkCreateFence(mDevice, &fenceInfo, nullptr, &mComputeFence) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create compute synchronization objects!\n");
+	}
+}
+
+/// <summary>
+/// Records and submits a dispatch on the compute queue; the next
+/// graphics submit waits on its semaphore
+/// </summary>
+/// <param name="groupCountX"></param>
+/// <param name="groupCountY"></param>
+/// <param name="groupCountZ"></param>
+void VulkanRenderer::dispatchCompute(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	if (mComputePipeline == VK_NULL_HANDLE)
+	{
+		throw std::runtime_error("ERROR: dispatchCompute called before setupCompute!\n");
+	}
+
+	//Don't re-record while the previous dispatch is still running
+	vkWaitForFences(mDevice, 1, &mComputeFence, VK_TRUE, UINT64_MAX);
+	vkResetFences(mDevice, 1, &mComputeFence);
+
+	vkResetCommandBuffer(mComputeCommandBuffer, 0);
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(mComputeCommandBuffer, &beginInfo);
+
+	vkCmdBindPipeline(mComputeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mComputePipeline);
+	vkCmdBindDescriptorSets(mComputeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+		mComputePipelineLayout, 0, 1, &mComputeDescriptorSet, 0, nullptr);
+
+	vkCmdDispatch(mComputeCommandBuffer, groupCountX, groupCountY, groupCountZ);
+
+	//A dedicated compute family doesn't share buffer ownership with
+	//the graphics family; release the contents here, the matching
+	//acquire rides in the next graphics submit (the streamed uploads
+	//follow the same pattern)
+	if (mComputeFamilyIndex != mGraphicsFamilyIndex)
+	{
+		VkBufferMemoryBarrier release{};
+		release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		release.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		release.dstAccessMask = 0;
+		release.srcQueueFamilyIndex = mComputeFamilyIndex;
+		release.dstQueueFamilyIndex = mGraphicsFamilyIndex;
+		release.buffer = mComputeStorageBuffer;
+		release.offset = 0;
+		release.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(mComputeCommandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 1, &release, 0, nullptr);
+	}
+
+	vkEndCommandBuffer(mComputeCommandBuffer);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &mComputeCommandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &mComputeFinishedSemaphore;
+
+	//Back-to-back dispatches with no drawFrame between them would
+	//double-signal the binary semaphore; consume the still-pending
+	//signal in this same submit before re-signaling it
+	VkPipelineStageFlags computeWaitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	if (mComputePending)
+	{
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &mComputeFinishedSemaphore;
+		submitInfo.pWaitDstStageMask = &computeWaitStage;
+	}
+
+	if (vkQueueSubmit(mComputeQueue, 1, &submitInfo, mComputeFence) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to submit compute dispatch!\n");
+	}
+
+	mComputePending = true;
+}
+
+/// <summary>
+/// How many recording jobs the registered draws are split into
+/// </summary>
+/// <returns></returns>
+uint32_t VulkanRenderer::getRecordJobCount() const
+{
+	//Indirect mode records a single draw regardless of mesh count
+	if (mIndirectDrawEnabled)
+	{
+		return 1;
+	}
+
+	return std::min(mWorkerCount, std::max(1u, (uint32_t)mMeshes.size()));
+}
+
+/// <summary>
+/// Creates the timestamp query pool used to measure GPU
+/// time across the render pass
+/// </summary>
+void VulkanRenderer::createTimestampQueryPool()
+{
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(mPhysicalDevice, &deviceProperties);
+
+	mTimestampPeriod = deviceProperties.limits.timestampPeriod;
+	mTimestampsSupported = deviceProperties.limits.timestampComputeAndGraphics == VK_TRUE;
+
+	if (!mTimestampsSupported)
+	{
+		return;
+	}
+
+	//Two timestamps (start/end of render pass) per swap-chain image
+	VkQueryPoolCreateInfo queryPoolInfo{};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = (uint32_t)mSwapChainImages.size() * 2;
+
+	if (vkCreateQueryPool(mDevice, &queryPoolInfo, nullptr, &mTimestampQueryPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create timestamp query pool!\n");
+	}
+}
+
+/// <summary>
+/// Creates the pipeline-statistics and occlusion query pools used
+/// by the GPU counter mode (one query of each per swap-chain image)
+/// </summary>
+void VulkanRenderer::createGpuCounterQueryPools()
+{
+	if (!mGpuCountersActive)
+	{
+		return;
+	}
+
+	VkQueryPoolCreateInfo statsPoolInfo{};
+	statsPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	statsPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+	statsPoolInfo.queryCount = (uint32_t)mSwapChainImages.size();
+	statsPoolInfo.pipelineStatistics = PIPELINE_STATS_FLAGS;
+
+	if (vkCreateQueryPool(mDevice, &statsPoolInfo, nullptr, &mPipelineStatsQueryPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create pipeline statistics query pool!\n");
+	}
+
+	VkQueryPoolCreateInfo occlusionPoolInfo{};
+	occlusionPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	occlusionPoolInfo.queryType = VK_QUERY_TYPE_OCCLUSION;
+	occlusionPoolInfo.queryCount = (uint32_t)mSwapChainImages.size();
+
+	if (vkCreateQueryPool(mDevice, &occlusionPoolInfo, nullptr, &mOcclusionQueryPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create occlusion query pool!\n");
+	}
+}
+
+/// <summary>
+/// Reads back the GPU counters of an image's last submission into
+/// the sample; a not-ready query leaves its fields at zero (no WAIT
+/// flag, so the CPU never stalls on the GPU here)
+/// </summary>
+/// <param name="imageIndex"></param>
+/// <param name="sample"></param>
+void VulkanRenderer::readGpuCounters(uint32_t imageIndex, FrameSample& sample)
+{
+	if (!mGpuCountersActive)
+	{
+		return;
+	}
+
+	//One uint64_t per statistic, in PIPELINE_STATS_FLAGS bit order
+	uint64_t stats[5];
+
+	VkResult result = vkGetQueryPoolResults(mDevice, mPipelineStatsQueryPool,
+		imageIndex, 1, sizeof(stats), stats,
+		sizeof(stats), VK_QUERY_RESULT_64_BIT);
+
+	if (result == VK_SUCCESS)
+	{
+		sample.inputVertices = stats[0];
+		sample.inputPrimitives = stats[1];
+		sample.vertexInvocations = stats[2];
+		sample.clippedPrimitives = stats[3];
+		sample.fragmentInvocations = stats[4];
+	}
+
+	uint64_t samplesPassed = 0;
+
+	result = vkGetQueryPoolResults(mDevice, mOcclusionQueryPool,
+		imageIndex, 1, sizeof(samplesPassed), &samplesPassed,
+		sizeof(samplesPassed), VK_QUERY_RESULT_64_BIT);
+
+	if (result == VK_SUCCESS)
+	{
+		sample.samplesPassed = samplesPassed;
+	}
+}
+
+/// <summary>
+/// Reads back the render pass duration of an image's last submission,
+/// returning 0 when the queries haven't completed yet
+/// </summary>
+/// <param name="imageIndex"></param>
+/// <returns></returns>
+double VulkanRenderer::readGpuFrameTime(uint32_t imageIndex)
+{
+	if (!mTimestampsSupported)
+	{
+		return 0.0;
+	}
+
+	uint64_t timestamps[2];
+
+	//No WAIT flag; a not-ready query simply reports zero
+	VkResult result = vkGetQueryPoolResults(mDevice, mTimestampQueryPool,
+		imageIndex * 2, 2, sizeof(timestamps), timestamps,
+		sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	if (result != VK_SUCCESS)
+	{
+		return 0.0;
+	}
+
+	//timestampPeriod is in nanoseconds per tick
+	return (double)(timestamps[1] - timestamps[0]) * (double)mTimestampPeriod / 1000000.0;
+}
+
+/// <summary>
+/// Fetches the debug-utils naming and label entry points; they stay
+/// null (and every call below becomes a no-op) when the extension
+/// isn't enabled on the instance
+/// </summary>
+void VulkanRenderer::loadDebugUtilsFunctions()
+{
+#ifndef NDEBUG
+	mSetDebugUtilsObjectNameEXT = (PFN_vkSetDebugUtilsObjectNameEXT)
+		vkGetInstanceProcAddr(mInstance, "vkSetDebugUtilsObjectNameEXT");
+	mCmdBeginDebugUtilsLabelEXT = (PFN_vkCmdBeginDebugUtilsLabelEXT)
+		vkGetInstanceProcAddr(mInstance, "vkCmdBeginDebugUtilsLabelEXT");
+	mCmdEndDebugUtilsLabelEXT = (PFN_vkCmdEndDebugUtilsLabelEXT)
+		vkGetInstanceProcAddr(mInstance, "vkCmdEndDebugUtilsLabelEXT");
+#endif
+}
+
+/// <summary>
+/// Attaches a human-readable name to a Vulkan handle so RenderDoc and
+/// Nsight captures show it instead of an anonymous hex value
+/// </summary>
+/// <param name="objectHandle"></param>
+/// <param name="objectType"></param>
+/// <param name="name"></param>
+void VulkanRenderer::setObjectName(uint64_t objectHandle, VkObjectType objectType,
+	const char* name) const
+{
+#ifndef NDEBUG
+	if (mSetDebugUtilsObjectNameEXT == nullptr || objectHandle == 0)
+	{
+		return;
+	}
+
+	VkDebugUtilsObjectNameInfoEXT nameInfo{};
+	nameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+	nameInfo.objectType = objectType;
+	nameInfo.objectHandle = objectHandle;
+	nameInfo.pObjectName = name;
+
+	mSetDebugUtilsObjectNameEXT(mDevice, &nameInfo);
+#endif
+}
+
+/// <summary>
+/// Opens a named region in a command buffer for capture tools
+/// </summary>
+/// <param name="commandBuffer"></param>
+/// <param name="labelName"></param>
+void VulkanRenderer::beginCommandLabel(VkCommandBuffer commandBuffer,
+	const char* labelName) const
+{
+#ifndef NDEBUG
+	if (mCmdBeginDebugUtilsLabelEXT == nullptr)
+	{
+		return;
+	}
+
+	VkDebugUtilsLabelEXT label{};
+	label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+	label.pLabelName = labelName;
+
+	mCmdBeginDebugUtilsLabelEXT(commandBuffer, &label);
+#endif
+}
+
+/// <summary>
+/// Closes the innermost open command-buffer region
+/// </summary>
+/// <param name="commandBuffer"></param>
+void VulkanRenderer::endCommandLabel(VkCommandBuffer commandBuffer) const
+{
+#ifndef NDEBUG
+	if (mCmdEndDebugUtilsLabelEXT != nullptr)
+	{
+		mCmdEndDebugUtilsLabelEXT(commandBuffer);
+	}
+#endif
+}
+
+/// <summary>
+/// Forwards a drawFrame stage start to the external CPU profiler
+/// </summary>
+/// <param name="zoneName"></param>
+void VulkanRenderer::profileZoneBegin(const char* zoneName) const
+{
+#ifndef NDEBUG
+	if (mProfilerBeginZone != nullptr)
+	{
+		mProfilerBeginZone(zoneName);
+	}
+#endif
+}
+
+/// <summary>
+/// Forwards a drawFrame stage end to the external CPU profiler
+/// </summary>
+/// <param name="zoneName"></param>
+void VulkanRenderer::profileZoneEnd(const char* zoneName) const
+{
+#ifndef NDEBUG
+	if (mProfilerEndZone != nullptr)
+	{
+		mProfilerEndZone(zoneName);
+	}
+#endif
+}
+
+/// <summary>
+/// Names the long-lived handles created during init; resources rebuilt
+/// mid-run (mesh buffers, textures) are re-named where they are created
+/// </summary>
+void VulkanRenderer::nameCoreObjects()
+{
+#ifndef NDEBUG
+	setObjectName((uint64_t)mGraphicsPipeline, VK_OBJECT_TYPE_PIPELINE, "Base graphics pipeline");
+	setObjectName((uint64_t)mRenderPass, VK_OBJECT_TYPE_RENDER_PASS, "Main render pass");
+	setObjectName((uint64_t)mDepthImage, VK_OBJECT_TYPE_IMAGE, "Depth attachment");
+	setObjectName((uint64_t)mDepthImageView, VK_OBJECT_TYPE_IMAGE_VIEW, "Depth attachment view");
+	setObjectName((uint64_t)mStagingBuffer, VK_OBJECT_TYPE_BUFFER, "Upload staging buffer");
+
+	for (size_t i = 0; i < mSwapChainImages.size(); i++)
+	{
+		std::string name = "Swap chain image " + std::to_string(i);
+		setObjectName((uint64_t)mSwapChainImages[i], VK_OBJECT_TYPE_IMAGE, name.c_str());
+
+		name = "Frame command buffer " + std::to_string(i);
+		setObjectName((uint64_t)mCommandBuffers[i], VK_OBJECT_TYPE_COMMAND_BUFFER, name.c_str());
 
-	//Specify uniforms in pipeline layout
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 0;
-	pipelineLayoutInfo.pSetLayouts = nullptr;
-	pipelineLayoutInfo.pushConstantRangeCount = 0;
-	pipelineLayoutInfo.pPushConstantRanges = nullptr;
+		name = "Uniform buffer " + std::to_string(i);
+		setObjectName((uint64_t)mUniformBuffers[i], VK_OBJECT_TYPE_BUFFER, name.c_str());
+	}
+#endif
+}
 
-	if (vkCreatePipelineLayout(mDevice, &pipelineLayoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS)
+/// <summary>
+/// Describes the uniform buffer and texture sampler bindings
+/// visible to the shaders
+/// </summary>
+void VulkanRenderer::createDescriptorSetLayout()
+{
+	VkDescriptorSetLayoutBinding uboLayoutBinding{};
+	uboLayoutBinding.binding = 0;
+	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBinding.descriptorCount = 1;
+	uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	uboLayoutBinding.pImmutableSamplers = nullptr;
+
+	VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+	samplerLayoutBinding.binding = 1;
+	samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	samplerLayoutBinding.descriptorCount = 1;
+	samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	samplerLayoutBinding.pImmutableSamplers = nullptr;
+
+	std::array<VkDescriptorSetLayoutBinding, 2> bindings =
+		{uboLayoutBinding, samplerLayoutBinding};
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = (uint32_t)bindings.size();
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &mDescriptorSetLayout) != VK_SUCCESS)
 	{
-		throw std::runtime_error("ERROR: Failed to create pipeline layout!\n");
+		throw std::runtime_error("ERROR: Failed to create descriptor set layout!\n");
 	}
+}
 
-	//Create the graphics pipeline
-	VkGraphicsPipelineCreateInfo pipelineInfo{};
-	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineInfo.stageCount = 2;
-	pipelineInfo.pStages = shaderStages;
+/// <summary>
+/// Creates the per-image uniform buffer ring, persistently mapped
+/// so drawFrame never calls vkMapMemory
+/// </summary>
+void VulkanRenderer::createUniformBuffers()
+{
+	VkDeviceSize bufferSize = sizeof(UniformBufferObject);
 
-	pipelineInfo.pVertexInputState = &vertexInputInfo;
-	pipelineInfo.pInputAssemblyState = &inputAssembly;
-	pipelineInfo.pViewportState = &viewportState;
-	pipelineInfo.pRasterizationState = &rasterizer;
-	pipelineInfo.pMultisampleState = &multisampling;
-	pipelineInfo.pDepthStencilState = nullptr; //Disabled for now
-	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.pDynamicState = &dynamicState;
+	mUniformBuffers.resize(mSwapChainImages.size());
+	mUniformBufferAllocations.resize(mSwapChainImages.size());
+	mUniformBuffersMapped.resize(mSwapChainImages.size());
 
-	pipelineInfo.layout = mPipelineLayout;
-	pipelineInfo.renderPass = mRenderPass;
-	pipelineInfo.subpass = 0;
+	for (size_t i = 0; i < mUniformBuffers.size(); i++)
+	{
+		createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			mUniformBuffers[i], mUniformBufferAllocations[i]);
 
-	//Used to set up a new pipeline from an existing one
-	//See (VK_PIPELINE_CREATE_DERIVATIVE_BIT)
-	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-	pipelineInfo.basePipelineIndex = -1;
+		//Map once here and write through the pointer every frame
+		mUniformBuffersMapped[i] = mAllocator.map(mUniformBufferAllocations[i]);
+	}
+}
 
-	if (vkCreateGraphicsPipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &mGraphicsPipeline) != VK_SUCCESS)
+/// <summary>
+/// Creates a pool big enough for one descriptor set per uniform buffer
+/// </summary>
+void VulkanRenderer::createDescriptorPool()
+{
+	std::array<VkDescriptorPoolSize, 2> poolSizes{};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].descriptorCount = (uint32_t)mUniformBuffers.size();
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[1].descriptorCount = (uint32_t)mUniformBuffers.size();
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = (uint32_t)poolSizes.size();
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = (uint32_t)mUniformBuffers.size();
+
+	if (vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &mDescriptorPool) != VK_SUCCESS)
 	{
-		throw std::runtime_error("ERROR: Failed to create Graphics Pipeline!\n");
+		throw std::runtime_error("ERROR: Failed to create descriptor pool!\n");
 	}
-
-	//Cleanup shader modules
-	vkDestroyShaderModule(mDevice, fragShaderModule, nullptr);
-	vkDestroyShaderModule(mDevice, vertShaderModule, nullptr);
 }
 
 /// <summary>
-/// Initializes framebuffers using the swap chains formats and settings
+/// Allocates a descriptor set per uniform buffer and points it at its buffer
 /// </summary>
-void VulkanRenderer::createFramebuffers()
+void VulkanRenderer::createDescriptorSets()
 {
-	//Resize to hold all framebuffers
-	mSwapChainFramebuffers.resize(mSwapChainImageViews.size());
+	std::vector<VkDescriptorSetLayout> layouts(mUniformBuffers.size(), mDescriptorSetLayout);
 
-	//Create framebuffers from image views
-	for (size_t i = 0; i < mSwapChainImageViews.size(); i++)
-	{
-		VkImageView attachments[] = {
-			mSwapChainImageViews[i]
-		};
+	VkDescriptorSetAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = mDescriptorPool;
+	allocateInfo.descriptorSetCount = (uint32_t)layouts.size();
+	allocateInfo.pSetLayouts = layouts.data();
 
-		VkFramebufferCreateInfo framebufferInfo{};
-		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebufferInfo.renderPass = mRenderPass;
-		framebufferInfo.attachmentCount = 1;
-		framebufferInfo.pAttachments = attachments;
-		framebufferInfo.width = mSwapChainExtent.width;
-		framebufferInfo.height = mSwapChainExtent.height;
-		framebufferInfo.layers = 1;
+	mDescriptorSets.resize(layouts.size());
+	if (vkAllocateDescriptorSets(mDevice, &allocateInfo, mDescriptorSets.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to allocate descriptor sets!\n");
+	}
 
-		if (vkCreateFramebuffer(mDevice, &framebufferInfo, nullptr, &mSwapChainFramebuffers[i]) != VK_SUCCESS)
-		{
-			throw std::runtime_error("ERROR: Failed to create framebuffer\n");
-		}
+	for (size_t i = 0; i < mDescriptorSets.size(); i++)
+	{
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = mUniformBuffers[i];
+		bufferInfo.offset = 0;
+		bufferInfo.range = sizeof(UniformBufferObject);
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = mTextureImageView;
+		imageInfo.sampler = mTextureSampler;
+
+		std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[0].dstSet = mDescriptorSets[i];
+		descriptorWrites[0].dstBinding = 0;
+		descriptorWrites[0].dstArrayElement = 0;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[0].descriptorCount = 1;
+		descriptorWrites[0].pBufferInfo = &bufferInfo;
+
+		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[1].dstSet = mDescriptorSets[i];
+		descriptorWrites[1].dstBinding = 1;
+		descriptorWrites[1].dstArrayElement = 0;
+		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[1].descriptorCount = 1;
+		descriptorWrites[1].pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(mDevice, (uint32_t)descriptorWrites.size(),
+			descriptorWrites.data(), 0, nullptr);
 	}
 }
 
 /// <summary>
-/// Creates a command pool using queue family indices
+/// Writes this image's shader globals through the persistent mapping
 /// </summary>
-void VulkanRenderer::createCommandPool()
+/// <param name="imageIndex"></param>
+void VulkanRenderer::updateUniformBuffer(uint32_t imageIndex)
 {
-	QueueFamilyIndices queueFamilyIndices = findQueueFamilies(mPhysicalDevice);
+	static auto startTime = std::chrono::high_resolution_clock::now();
 
-	VkCommandPoolCreateInfo poolInfo{};
-	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-	poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+	auto currentTime = std::chrono::high_resolution_clock::now();
+	float time = std::chrono::duration<float>(currentTime - startTime).count();
 
-	if (vkCreateCommandPool(mDevice, &poolInfo, nullptr, &mCommandPool) != VK_SUCCESS)
+	UniformBufferObject ubo{};
+	ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f));
+	ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f),
+		glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	ubo.proj = glm::perspective(glm::radians(45.0f),
+		(float)mSwapChainExtent.width / (float)mSwapChainExtent.height, 0.1f, 10.0f);
+
+	//GLM is OpenGL-oriented; flip Y for vulkan clip space
+	ubo.proj[1][1] *= -1;
+
+	memcpy(mUniformBuffersMapped[imageIndex], &ubo, sizeof(ubo));
+}
+
+/// <summary>
+/// Creates a buffer and allocates and binds memory with the requested properties
+/// </summary>
+/// <param name="size"></param>
+/// <param name="usage"></param>
+/// <param name="properties"></param>
+/// <param name="buffer"></param>
+/// <param name="bufferMemory"></param>
+void VulkanRenderer::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+	VkMemoryPropertyFlags properties,
+	VkBuffer& buffer, GpuAllocation& allocation)
+{
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+
+	//Buffers can have multiple usages
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	bufferInfo.flags = 0;
+
+	if (vkCreateBuffer(mDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
 	{
-		throw std::runtime_error("ERROR: Failed to create command pool!\n");
+		throw std::runtime_error("ERROR: Failed to create buffer!\n");
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetBufferMemoryRequirements(mDevice, buffer, &memoryRequirements);
+
+	//Sub-allocate out of a slab rather than a dedicated vkAllocateMemory
+	allocation = mAllocator.allocate(memoryRequirements, properties);
+
+	if (vkBindBufferMemory(mDevice, buffer, allocation.memory, allocation.offset) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to bind buffer memory!\n");
 	}
 }
 
 /// <summary>
-/// Creates command buffers using the command pool
+/// Records and submits a transfer of size bytes between two buffers
 /// </summary>
-void VulkanRenderer::createCommandBuffers()
+/// <param name="srcBuffer"></param>
+/// <param name="dstBuffer"></param>
+/// <param name="size"></param>
+void VulkanRenderer::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size,
+	VkDeviceSize srcOffset, VkDeviceSize dstOffset)
 {
-	//Resize command buffers vector to
-	//our max amount of parallel frames
-	mCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	VkBufferCopy copyRegion{};
+	copyRegion.srcOffset = srcOffset;
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size = size;
+	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
+	endSingleTimeCommands(commandBuffer);
+}
+
+/// <summary>
+/// Allocates a throwaway command buffer for a one-off transfer
+/// </summary>
+/// <returns></returns>
+VkCommandBuffer VulkanRenderer::beginSingleTimeCommands()
+{
 	VkCommandBufferAllocateInfo allocateInfo{};
 	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocateInfo.commandPool = mCommandPool;
 	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocateInfo.commandBufferCount = (uint32_t) mCommandBuffers.size();
+	allocateInfo.commandPool = mCommandPool;
+	allocateInfo.commandBufferCount = 1;
 
-	if (vkAllocateCommandBuffers(mDevice, &allocateInfo, mCommandBuffers.data()) != VK_SUCCESS)
-	{
-		throw std::runtime_error("ERROR: Failed to create command buffers!\n");
-	}
+	VkCommandBuffer commandBuffer;
+	vkAllocateCommandBuffers(mDevice, &allocateInfo, &commandBuffer);
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	return commandBuffer;
 }
 
 /// <summary>
-/// Starts recording the command buffer and the render pass
+/// Submits a single-use command buffer and blocks until it finishes
 /// </summary>
 /// <param name="commandBuffer"></param>
-/// <param name="imageIndex"></param>
-void VulkanRenderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+void VulkanRenderer::endSingleTimeCommands(VkCommandBuffer commandBuffer)
 {
-	//Begin recording command buffer
-	VkCommandBufferBeginInfo beginInfo{};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = 0;
-	beginInfo.pInheritanceInfo = nullptr;
+	vkEndCommandBuffer(commandBuffer);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
 
-	if (vkBeginCommandBuffer(mCommandBuffers[mCurrentFrame], &beginInfo) != VK_SUCCESS)
+	if (vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
 	{
-		throw std::runtime_error("ERROR: Failed to begin recording command buffer!\n");
+		throw std::runtime_error("ERROR: Failed to submit single-use commands!\n");
 	}
 
-	//Start render pass
-	VkRenderPassBeginInfo renderPassInfo{};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass = mRenderPass;
-	renderPassInfo.framebuffer = mSwapChainFramebuffers[imageIndex];
+	//Wait for the commands to finish before the caller reuses
+	//anything they touched
+	vkQueueWaitIdle(mGraphicsQueue);
 
-	renderPassInfo.renderArea.offset = {0, 0};
-	renderPassInfo.renderArea.extent = mSwapChainExtent;
+	vkFreeCommandBuffers(mDevice, mCommandPool, 1, &commandBuffer);
+}
 
-	VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-	renderPassInfo.clearValueCount = 1;
-	renderPassInfo.pClearValues = &clearColor;
+/// <summary>
+/// Grows the reusable staging buffer if the requested upload doesn't fit
+/// </summary>
+/// <param name="size"></param>
+void VulkanRenderer::ensureStagingBuffer(VkDeviceSize size)
+{
+	if (mStagingBufferSize >= size)
+	{
+		return;
+	}
 
-	vkCmdBeginRenderPass(mCommandBuffers[mCurrentFrame], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	//Replace the old staging buffer with a bigger one
+	if (mStagingBuffer != VK_NULL_HANDLE)
+	{
+		vkDestroyBuffer(mDevice, mStagingBuffer, nullptr);
+		mAllocator.free(mStagingBufferAllocation);
+	}
 
-	//Bind the graphics pipeline (VK_PIPELINE_BIND_POINT_COMPUTE for compute pipelines)
-	vkCmdBindPipeline(mCommandBuffers[mCurrentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
+	createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		mStagingBuffer, mStagingBufferAllocation);
 
-	//Specify our dynamic pipeline values here
-	VkViewport viewport{};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = (float) mSwapChainExtent.width;
-	viewport.height = (float) mSwapChainExtent.height;
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
+	mStagingBufferSize = size;
+}
+#pragma endregion
 
-	//Update our viewport
-	vkCmdSetViewport(mCommandBuffers[mCurrentFrame], 0, 1, &viewport);
+#pragma region Texture Functions
+/// <summary>
+/// Creates an image and allocates and binds memory with the requested properties
+/// </summary>
+/// <param name="width"></param>
+/// <param name="height"></param>
+/// <param name="mipLevels"></param>
+/// <param name="format"></param>
+/// <param name="tiling"></param>
+/// <param name="usage"></param>
+/// <param name="properties"></param>
+/// <param name="image"></param>
+/// <param name="allocation"></param>
+void VulkanRenderer::createImage(uint32_t width, uint32_t height, uint32_t mipLevels,
+	VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
+	VkMemoryPropertyFlags properties,
+	VkImage& image, GpuAllocation& allocation)
+{
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent.width = width;
+	imageInfo.extent.height = height;
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = mipLevels;
+	imageInfo.arrayLayers = 1;
+	imageInfo.format = format;
+	imageInfo.tiling = tiling;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = usage;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateImage(mDevice, &imageInfo, nullptr, &image) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create image!\n");
+	}
 
-	VkRect2D scissor{};
-	scissor.offset = {0, 0};
-	scissor.extent = mSwapChainExtent;
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements(mDevice, image, &memoryRequirements);
 
-	//Update our scissor
-	vkCmdSetScissor(mCommandBuffers[mCurrentFrame], 0, 1, &scissor);
+	//Images share slabs with buffers, so pad the alignment up to
+	//bufferImageGranularity to keep them in separate pages; the size
+	//is rounded up too, or the allocator's free-list remainder would
+	//start inside the image's last granularity page and a later small
+	//buffer could land in it
+	VkPhysicalDeviceProperties deviceProperties{};
+	vkGetPhysicalDeviceProperties(mPhysicalDevice, &deviceProperties);
 
-	vkCmdBindPipeline(mCommandBuffers[mCurrentFrame],
-		VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
-	VkBuffer vertexBuffers[] = {mVertexBuffer};
-	VkDeviceSize offsets[] = {0};
-	vkCmdBindVertexBuffers(mCommandBuffers[mCurrentFrame],
-		0, 1, vertexBuffers, offsets);
+	VkDeviceSize granularity = deviceProperties.limits.bufferImageGranularity;
+	memoryRequirements.alignment = std::max(memoryRequirements.alignment, granularity);
+	memoryRequirements.size = (memoryRequirements.size + granularity - 1)
+		& ~(granularity - 1);
 
-	//Issue draw command for triangle
-	vkCmdDraw(mCommandBuffers[mCurrentFrame], (uint32_t)VERTICES.size(), 1, 0, 0);
+	allocation = mAllocator.allocate(memoryRequirements, properties);
 
-	vkCmdEndRenderPass(mCommandBuffers[mCurrentFrame]);
-	if (vkEndCommandBuffer(mCommandBuffers[mCurrentFrame]) != VK_SUCCESS)
+	if (vkBindImageMemory(mDevice, image, allocation.memory, allocation.offset) != VK_SUCCESS)
 	{
-		throw std::runtime_error("ERROR: Failed to record command buffer!\n");
+		throw std::runtime_error("ERROR: Failed to bind image memory!\n");
 	}
 }
 
 /// <summary>
-/// Creates Semaphores and fences that are used to keep the CPU and GPU in sync
+/// Creates a 2D view over the given image
 /// </summary>
-void VulkanRenderer::createSyncObjects()
+/// <param name="image"></param>
+/// <param name="format"></param>
+/// <param name="mipLevels"></param>
+/// <param name="aspectFlags"></param>
+/// <returns></returns>
+VkImageView VulkanRenderer::createImageView(VkImage image, VkFormat format, uint32_t mipLevels,
+	VkImageAspectFlags aspectFlags)
 {
-	mImageAvailableSemaphore.resize(MAX_FRAMES_IN_FLIGHT);
-	mRenderFinishedSemaphore.resize(MAX_FRAMES_IN_FLIGHT);
-	mInFlightFence.resize(MAX_FRAMES_IN_FLIGHT);
+	VkImageViewCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	createInfo.image = image;
+	createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	createInfo.format = format;
+	createInfo.subresourceRange.aspectMask = aspectFlags;
+	createInfo.subresourceRange.baseMipLevel = 0;
+	createInfo.subresourceRange.levelCount = mipLevels;
+	createInfo.subresourceRange.baseArrayLayer = 0;
+	createInfo.subresourceRange.layerCount = 1;
+
+	VkImageView imageView;
+	if (vkCreateImageView(mDevice, &createInfo, nullptr, &imageView) != VK_SUCCESS)
+	{
+		throw std::runtime_error("ERROR: Failed to create image view!\n");
+	}
+	return imageView;
+}
 
-	VkSemaphoreCreateInfo semaphoreInfo{};
-	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+/// <summary>
+/// Transitions every mip level of an image between the layouts the
+/// upload path needs
+/// </summary>
+/// <param name="image"></param>
+/// <param name="oldLayout"></param>
+/// <param name="newLayout"></param>
+/// <param name="mipLevels"></param>
+void VulkanRenderer::transitionImageLayout(VkImage image, VkImageLayout oldLayout,
+	VkImageLayout newLayout, uint32_t mipLevels)
+{
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	VkPipelineStageFlags sourceStage;
+	VkPipelineStageFlags destinationStage;
+
+	if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED &&
+	    newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+	{
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	} else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
+	           newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+	{
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	} else
+	{
+		throw std::runtime_error("ERROR: Unsupported image layout transition!\n");
+	}
 
-	VkFenceCreateInfo fenceInfo{};
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+	vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage,
+		0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	endSingleTimeCommands(commandBuffer);
+}
+
+/// <summary>
+/// Copies tightly packed pixels from a buffer into mip level 0
+/// </summary>
+/// <param name="buffer"></param>
+/// <param name="image"></param>
+/// <param name="width"></param>
+/// <param name="height"></param>
+void VulkanRenderer::copyBufferToImage(VkBuffer buffer, VkImage image,
+	uint32_t width, uint32_t height)
+{
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	VkBufferImageCopy region{};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = {0, 0, 0};
+	region.imageExtent = {width, height, 1};
+
+	vkCmdCopyBufferToImage(commandBuffer, buffer, image,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	endSingleTimeCommands(commandBuffer);
+}
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+/// <summary>
+/// Builds the mip chain on the GPU by blitting each level down from
+/// the one above it, leaving the whole image shader-readable
+/// </summary>
+/// <param name="image"></param>
+/// <param name="format"></param>
+/// <param name="width"></param>
+/// <param name="height"></param>
+/// <param name="mipLevels"></param>
+void VulkanRenderer::generateMipmaps(VkImage image, VkFormat format,
+	int32_t width, int32_t height, uint32_t mipLevels)
+{
+	//Blitting needs linear filtering on the source format
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(mPhysicalDevice, format, &formatProperties);
+
+	if (!(formatProperties.optimalTilingFeatures &
+	      VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
 	{
-		if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &mImageAvailableSemaphore[i]) != VK_SUCCESS ||
-		    vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &mRenderFinishedSemaphore[i]) != VK_SUCCESS ||
-		    vkCreateFence(mDevice, &fenceInfo, nullptr, &mInFlightFence[i]) != VK_SUCCESS)
+		throw std::runtime_error("ERROR: Texture format does not support linear blitting!\n");
+	}
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.image = image;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.subresourceRange.levelCount = 1;
+
+	int32_t mipWidth = width;
+	int32_t mipHeight = height;
+
+	for (uint32_t i = 1; i < mipLevels; i++)
+	{
+		//Previous level: transfer destination -> blit source
+		barrier.subresourceRange.baseMipLevel = i - 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkImageBlit blit{};
+		blit.srcOffsets[0] = {0, 0, 0};
+		blit.srcOffsets[1] = {mipWidth, mipHeight, 1};
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = i - 1;
+		blit.srcSubresource.baseArrayLayer = 0;
+		blit.srcSubresource.layerCount = 1;
+		blit.dstOffsets[0] = {0, 0, 0};
+		blit.dstOffsets[1] = {mipWidth > 1 ? mipWidth / 2 : 1,
+			mipHeight > 1 ? mipHeight / 2 : 1, 1};
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = i;
+		blit.dstSubresource.baseArrayLayer = 0;
+		blit.dstSubresource.layerCount = 1;
+
+		vkCmdBlitImage(commandBuffer,
+			image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &blit, VK_FILTER_LINEAR);
+
+		//Blit source -> shader readable
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		if (mipWidth > 1)
 		{
-			throw std::runtime_error("ERROR: Failed to create synchronization objects!\n");
+			mipWidth /= 2;
+		}
+		if (mipHeight > 1)
+		{
+			mipHeight /= 2;
 		}
 	}
+
+	//The last level was only ever a transfer destination
+	barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	endSingleTimeCommands(commandBuffer);
 }
 
-void VulkanRenderer::createVertexBuffer()
+/// <summary>
+/// Uploads tightly packed RGBA8 pixels into a new optimal-tiling,
+/// device-local texture and generates its mip chain; replaces any
+/// texture already bound
+/// </summary>
+/// <param name="pixels"></param>
+/// <param name="width"></param>
+/// <param name="height"></param>
+void VulkanRenderer::createTexture(const void* pixels, uint32_t width, uint32_t height)
 {
-	VkBufferCreateInfo bufferInfo{};
-	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	//Replacing a live texture: frames still sampling the old one
+	//keep it alive until their fences signal
+	if (mTextureImage != VK_NULL_HANDLE)
+	{
+		retireImage(mTextureImage, mTextureImageView, mTextureAllocation);
+		mTextureImage = VK_NULL_HANDLE;
+		mTextureImageView = VK_NULL_HANDLE;
+	}
 
-	//Size of vertex buffer
-	bufferInfo.size = sizeof(VERTICES[0]) * VERTICES.size();
+	mTextureMipLevels = (uint32_t)std::floor(
+		std::log2(std::max(width, height))) + 1;
 
-	//Vertex buffer can have multiple usages
-	bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	bufferInfo.flags = 0;
+	VkDeviceSize imageSize = (VkDeviceSize)width * height * 4;
+
+	ensureStagingBuffer(imageSize);
+	memcpy(mAllocator.map(mStagingBufferAllocation), pixels, (size_t)imageSize);
+
+	createImage(width, height, mTextureMipLevels, VK_FORMAT_R8G8B8A8_SRGB,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+		VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		mTextureImage, mTextureAllocation);
 
-	if (vkCreateBuffer(mDevice, &bufferInfo, nullptr, &mVertexBuffer) != VK_SUCCESS)
+	transitionImageLayout(mTextureImage, VK_IMAGE_LAYOUT_UNDEFINED,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mTextureMipLevels);
+	copyBufferToImage(mStagingBuffer, mTextureImage, width, height);
+	generateMipmaps(mTextureImage, VK_FORMAT_R8G8B8A8_SRGB,
+		(int32_t)width, (int32_t)height, mTextureMipLevels);
+
+	mTextureImageView = createImageView(mTextureImage,
+		VK_FORMAT_R8G8B8A8_SRGB, mTextureMipLevels);
+
+	setObjectName((uint64_t)mTextureImage, VK_OBJECT_TYPE_IMAGE, "Bound texture");
+	setObjectName((uint64_t)mTextureImageView, VK_OBJECT_TYPE_IMAGE_VIEW, "Bound texture view");
+
+	//Descriptor sets bound by pending command buffers may not be
+	//rewritten; waiting on the frame fences is enough, the retired
+	//image itself needed no stall at all
+	if (!mInFlightFence.empty())
 	{
-		throw std::runtime_error("ERROR: Failed to create vertex buffer!\n");
+		vkWaitForFences(mDevice, (uint32_t)mInFlightFence.size(),
+			mInFlightFence.data(), VK_TRUE, UINT64_MAX);
 	}
 
-	VkMemoryRequirements memoryRequirements;
-	vkGetBufferMemoryRequirements(mDevice, mVertexBuffer, &memoryRequirements);
-
-	VkMemoryAllocateInfo allocationInfo{};
-	allocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocationInfo.allocationSize = memoryRequirements.size;
-	allocationInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	//Point the live descriptor sets at the new texture
+	for (size_t i = 0; i < mDescriptorSets.size(); i++)
+	{
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = mTextureImageView;
+		imageInfo.sampler = mTextureSampler;
+
+		VkWriteDescriptorSet descriptorWrite{};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = mDescriptorSets[i];
+		descriptorWrite.dstBinding = 1;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(mDevice, 1, &descriptorWrite, 0, nullptr);
+	}
+}
 
-	if (vkAllocateMemory(mDevice, &allocationInfo, nullptr, &mVertexBufferMemory) != VK_SUCCESS)
+/// <summary>
+/// Creates the shared texture sampler with trilinear filtering and
+/// anisotropy when the hardware supports it
+/// </summary>
+void VulkanRenderer::createTextureSampler()
+{
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.anisotropyEnable = mSamplerAnisotropySupported ? VK_TRUE : VK_FALSE;
+	samplerInfo.maxAnisotropy = mSamplerAnisotropySupported ? mMaxSamplerAnisotropy : 1.0f;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.mipLodBias = 0.0f;
+	samplerInfo.minLod = 0.0f;
+
+	//No clamp so the full mip chain is always available
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	if (vkCreateSampler(mDevice, &samplerInfo, nullptr, &mTextureSampler) != VK_SUCCESS)
 	{
-		throw std::runtime_error("ERROR: Failed to allocate vertex buffer memory!\n");
+		throw std::runtime_error("ERROR: Failed to create texture sampler!\n");
 	}
+}
 
-	//After verifying allocation was successful we can now bind the memory
-	if (vkBindBufferMemory(mDevice, mVertexBuffer, mVertexBufferMemory, 0) != VK_SUCCESS)
+/// <summary>
+/// Generates a small checkerboard texture so sampling works before
+/// the application provides real pixels
+/// </summary>
+void VulkanRenderer::createDefaultTexture()
+{
+	constexpr uint32_t SIZE = 16;
+
+	std::vector<uint32_t> pixels(SIZE * SIZE);
+	for (uint32_t y = 0; y < SIZE; y++)
 	{
-		throw std::runtime_error("ERROR: Failed to bind vertex buffer memory!\n");
+		for (uint32_t x = 0; x < SIZE; x++)
+		{
+			//Alternating white and grey squares (ABGR in memory)
+			pixels[y * SIZE + x] = ((x / 4 + y / 4) % 2 == 0)
+				? 0xFFFFFFFF : 0xFF808080;
+		}
 	}
 
-	void* data;
-	vkMapMemory(mDevice, mVertexBufferMemory, 0, bufferInfo.size, 0, &data);
-	memcpy(data, VERTICES.data(), (size_t)bufferInfo.size);
-	vkUnmapMemory(mDevice, mVertexBufferMemory);
+	createTexture(pixels.data(), SIZE, SIZE);
+}
+
+/// <summary>
+/// Destroys the bound texture's view, image, and memory
+/// </summary>
+void VulkanRenderer::destroyTexture()
+{
+	vkDestroyImageView(mDevice, mTextureImageView, nullptr);
+	vkDestroyImage(mDevice, mTextureImage, nullptr);
+	mAllocator.free(mTextureAllocation);
+
+	mTextureImageView = VK_NULL_HANDLE;
+	mTextureImage = VK_NULL_HANDLE;
+	mTextureAllocation = GpuAllocation{};
 }
 #pragma endregion
 
@@ -1243,21 +5431,8 @@ VkShaderModule VulkanRenderer::createShaderModule(const std::vector<char> &code)
 
 uint32_t VulkanRenderer::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
 {
-	VkPhysicalDeviceMemoryProperties memoryProperties;
-	vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice, &memoryProperties);
-
-	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
-	{
-		//Check if a bit at index is set to 1
-		if (typeFilter & (1 << i) &&
-			(memoryProperties.memoryTypes[i].propertyFlags & properties) ==
-			properties)
-		{
-			return i;
-		}
-	}
-
-	throw std::runtime_error("ERROR: Failed to find suitable memory type!\n");
+	//Delegates to the allocator's cached memory properties
+	return mAllocator.findMemoryType(typeFilter, properties);
 }
 
 /// <summary>
@@ -1294,6 +5469,10 @@ std::vector<char> readFile(const std::string &filename)
 /// </summary>
 void VulkanRenderer::setupDebugMessenger()
 {
+	//The naming/label entry points stay null when the debug-utils
+	//extension isn't enabled, so this is safe either way
+	loadDebugUtilsFunctions();
+
 	if (!ENABLED_VALIDATION_LAYERS) return;
 
 	//Populate info for messenger
@@ -1435,8 +5614,11 @@ bool VulkanRenderer::hasRequiredExtensions()
 
 	uint32_t requiredCount = 0;
 
-	//Get required vulkan extensions
-	glfwGetRequiredInstanceExtensions(&requiredCount);
+	//Get required vulkan extensions (none from GLFW headless)
+	if (!mHeadless)
+	{
+		glfwGetRequiredInstanceExtensions(&requiredCount);
+	}
 
 	if (extensionCount < requiredCount)
 	{
@@ -1458,14 +5640,17 @@ bool VulkanRenderer::hasRequiredExtensions()
 /// <returns></returns>
 std::vector<const char *> VulkanRenderer::getRequiredExtensions()
 {
-	//Retrieve extension count
-	uint32_t extensionCount = 0;
+	std::vector<const char *> extensions{};
 
-	//Get required vulkan extensions
-	const char **glfwExtensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+	//The surface extensions come from GLFW, which headless runs
+	//never initialize
+	if (!mHeadless)
+	{
+		uint32_t extensionCount = 0;
+		const char **glfwExtensions = glfwGetRequiredInstanceExtensions(&extensionCount);
 
-	std::vector<const char *> extensions(glfwExtensions,
-	                                     glfwExtensions + extensionCount);
+		extensions.assign(glfwExtensions, glfwExtensions + extensionCount);
+	}
 
 	//Add debug extension
 	if (ENABLED_VALIDATION_LAYERS)
@@ -6,7 +6,17 @@
 #define VK_USE_PLATFORM_WIN32_KHR
 #define GLFW_EXPSOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
+
+#define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "GpuAllocator.h"
+#include "FrameStats.h"
+#include "ShaderManager.h"
+#include "VertexFormats.h"
+
+#include <taskflow/taskflow.hpp>
 
 #include <stdexcept>
 #include <cstdlib>
@@ -18,15 +28,22 @@
 #include <optional>
 #include <array>
 #include <cstdint>
+#include <cmath>
 #include <limits>
 #include <algorithm>
 #include <fstream>
 #include <filesystem>
+#include <thread>
+#include <mutex>
+#include <tuple>
+#include <chrono>
 
 constexpr uint32_t WIDTH = 800;
 constexpr uint32_t HEIGHT = 600;
 
-constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+//Default number of frames the CPU may record ahead of the GPU;
+//configurable through setMaxFramesInFlight before init
+constexpr uint32_t DEFAULT_MAX_FRAMES_IN_FLIGHT = 2;
 
 //const std::string WORKING_DIRECTORY = "../../../";
 
@@ -41,6 +58,27 @@ const std::vector<const char*> DEVICE_EXTENSIONS = {
 
 constexpr bool ENABLED_VALIDATION_LAYERS = true;
 
+//Where the serialized pipeline cache lives between runs
+const std::string PIPELINE_CACHE_FILE = "pipeline_cache.bin";
+
+//Async streaming ring: how many uploads can be in flight at once
+//and each slot's initial staging capacity
+constexpr uint32_t STREAMING_SLOT_COUNT = 3;
+constexpr VkDeviceSize STREAMING_SLOT_SIZE = 8 * 1024 * 1024;
+
+//How many offscreen color targets a headless run cycles through,
+//standing in for the swap-chain images
+constexpr uint32_t HEADLESS_IMAGE_COUNT = 3;
+
+//Which counters the GPU counter mode collects; the secondary command
+//buffers inherit this same set
+constexpr VkQueryPipelineStatisticFlags PIPELINE_STATS_FLAGS =
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
 static std::vector<char> readFile(const std::string& filename);
 
 /// <summary>
@@ -51,6 +89,14 @@ struct QueueFamilyIndices
 	std::optional<uint32_t> graphicsFamily{};
 	std::optional<uint32_t> presentFamily{};
 
+	//Compute-capable family, preferring one without graphics
+	//so compute work can overlap the render pass
+	std::optional<uint32_t> computeFamily{};
+
+	//Transfer-capable family, preferring a transfer-only one so
+	//streamed uploads don't contend with rendering
+	std::optional<uint32_t> transferFamily{};
+
 	bool isComplete() const
 	{
 		return graphicsFamily.has_value() && presentFamily.has_value();
@@ -68,48 +114,102 @@ struct SwapChainSupportDetails
 };
 
 /// <summary>
-/// Holds all vertex information
+/// Per-frame shader globals, laid out to match the
+/// uniform block in shader.vert
+/// </summary>
+struct UniformBufferObject
+{
+	glm::mat4 model{};
+	glm::mat4 view{};
+	glm::mat4 proj{};
+};
+
+/// <summary>
+/// CPU-side authoring vertex; buildMeshBuffers quantizes it into the
+/// split streams described by MeshVertexLayout before upload, so
+/// position must stay inside clip space [-1, 1] and uv inside [0, 1]
 /// </summary>
 struct Vertex
 {
 	glm::vec2 position{};
 	glm::vec3 color{};
+	glm::vec2 uv{};
+};
 
-	///Defines the stride of the binding
-	static VkVertexInputBindingDescription getBindingDescription()
-	{
-		VkVertexInputBindingDescription bindingDescription{};
-		bindingDescription.binding = 0;
-		bindingDescription.stride = sizeof(Vertex);
-		//Use instance here for instanced rendering
-		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-		return bindingDescription;
-	}
+const std::vector<Vertex> VERTICES = {
+	{{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
+	{{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
+	{{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+	{{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}}
+};
 
-	static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions()
-	{
-		std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
+//Indices into VERTICES so shared vertices are stored once
+const std::vector<uint32_t> INDICES = {
+	0, 1, 2, 2, 3, 0
+};
+
+//Identifies a mesh registered with the renderer
+using MeshHandle = uint32_t;
+
+/// <summary>
+/// Where a registered mesh lives inside the packed vertex/index buffers;
+/// fields mirror VkDrawIndexedIndirectCommand so the registry can feed
+/// indirect draw buffers directly
+/// </summary>
+struct MeshDraw
+{
+	uint32_t indexCount{};
+	uint32_t firstIndex{};
+	int32_t vertexOffset{};
+};
 
-		//Position description
-		attributeDescriptions[0].binding = 0;
-		attributeDescriptions[0].location = 0;
-		attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-		attributeDescriptions[0].offset = offsetof(Vertex, position);
+/// <summary>
+/// Render-state variant identifying a pipeline in the library;
+/// the defaults match the base pipeline built at init
+/// </summary>
+struct PipelineKey
+{
+	VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+	bool depthTest = true;
+	bool depthWrite = true;
 
-		//Color description
-		attributeDescriptions[1].binding = 0;
-		attributeDescriptions[1].location = 1;
-		attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-		attributeDescriptions[1].offset = offsetof(Vertex, color);
+	bool operator<(const PipelineKey& other) const
+	{
+		return std::tie(polygonMode, cullMode, depthTest, depthWrite) <
+			std::tie(other.polygonMode, other.cullMode, other.depthTest, other.depthWrite);
+	}
 
-		return attributeDescriptions;
+	bool operator==(const PipelineKey& other) const
+	{
+		return !(*this < other) && !(other < *this);
 	}
 };
 
-const std::vector<Vertex> VERTICES = {
-	{{0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}},
-	{{0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}},
-	{{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}}
+/// <summary>
+/// One enumerated adapter and its scoring breakdown, so applications
+/// can see why a device was picked or rejected
+/// </summary>
+struct DeviceInfo
+{
+	uint32_t index{};
+	std::string name{};
+	VkPhysicalDeviceType deviceType{};
+
+	//deviceUUID from VkPhysicalDeviceIDProperties, stable across runs
+	std::array<uint8_t, VK_UUID_SIZE> uuid{};
+
+	//Built-in heuristic breakdown; score is their sum, or whatever the
+	//application's scoring callback returned when one is installed
+	int typeScore{};
+	int limitScore{};
+	int surfaceScore{};
+	int score{};
+
+	//Whether the device passed the mandatory queue, extension, and
+	//surface checks; the reason is filled in when it didn't
+	bool suitable{};
+	std::string rejectionReason{};
 };
 
 /// <summary>
@@ -125,6 +225,128 @@ public:
 	void update();
 	void drawFrame();
 
+	//Invalidate the pre-recorded command buffers (resize, scene change)
+	void markCommandBuffersDirty();
+
+	//Force the next drawFrame to tear down and rebuild the swap chain
+	//as if the window had been resized (benchmark resize storms)
+	void requestSwapChainRecreate();
+
+	//Blocks until the GPU has finished all submitted work; call
+	//before tearing down a renderer driven by drawFrame directly
+	void waitIdle();
+
+	//How many frames the CPU may record ahead of the GPU; call before
+	//init, the value is clamped to the swap-chain image count
+	void setMaxFramesInFlight(uint32_t frames);
+
+	//Opt out of the VK_KHR_dynamic_rendering path before init; when
+	//the device lacks it the render-pass path is used automatically
+	void setDynamicRenderingEnabled(bool enabled);
+
+	//Device selection: every adapter with its scoring breakdown; safe
+	//to call before init (the instance is created on first use)
+	std::vector<DeviceInfo> enumerateDevices();
+
+	//Pin selection to an adapter by enumeration index or deviceUUID
+	//instead of trusting the heuristic (hybrid laptops: pick the GPU
+	//wired to the target display); call before init
+	void setPreferredDeviceIndex(uint32_t index);
+	void setPreferredDeviceUuid(const std::array<uint8_t, VK_UUID_SIZE>& uuid);
+
+	//Replaces the built-in scoring heuristic; the mandatory queue,
+	//extension, and surface checks still apply. Return <= 0 to reject
+	using DeviceScoringCallback = int(*)(VkPhysicalDevice device,
+		const VkPhysicalDeviceProperties& properties,
+		const VkPhysicalDeviceFeatures& features);
+	void setDeviceScoringCallback(DeviceScoringCallback callback);
+
+	//Present policy: which mode to ask the surface for (FIFO is the
+	//guaranteed fallback); changing it mid-run recreates the swap
+	//chain on the next frame
+	void setPresentMode(VkPresentModeKHR mode);
+
+	//Extra swap-chain images beyond the surface's minimum; more
+	//images smooth presentation, fewer cut latency
+	void setSwapChainImageMargin(uint32_t extraImages);
+
+	//Late-latch: block at the end of drawFrame until this frame's
+	//fence signals, trading CPU/GPU overlap for input-to-photon latency
+	void setLatencyWaitEnabled(bool enabled);
+
+	//Frame pacing: cap the main loop at a target rate with a hybrid
+	//sleep/spin wait, so MAILBOX runs stop burning a core on frames the
+	//presentation engine discards (0 removes the cap)
+	void setTargetFps(double fps);
+
+	//Idle the main loop in glfwWaitEventsTimeout while no window has
+	//focus, rendering at the given background rate instead of full tilt
+	void setIdleWhenUnfocused(bool enabled, double backgroundFps = 10.0);
+
+	//Multi-surface: opens another window driven by the same device,
+	//pipelines, and scene; every window's work goes into one queue
+	//submit and one present per frame. Call before init
+	void addWindow(uint32_t width, uint32_t height, const std::string& title);
+
+	//Headless mode: render into offscreen color targets with no
+	//window, swap chain, or present, so frame times are never capped
+	//by a present mode; call before init
+	void setHeadless(bool enabled);
+
+	//Bounds for the headless run loop; update() returns once either
+	//is reached (zero leaves that bound unset)
+	void setHeadlessRunLimits(uint64_t frameCount, double seconds);
+
+	//Copies the most recently rendered headless frame into tightly
+	//packed B8G8R8A8 pixels for hashing or disk dumps
+	std::vector<uint8_t> readbackHeadlessFrame();
+
+	//Frame-time instrumentation (percentiles, CSV output, report interval)
+	FrameStats& getFrameStats();
+
+	//GPU counters: a pipeline-statistics and an occlusion query around
+	//the render pass, read back fence-late into FrameStats to show
+	//whether a slow frame is vertex-, fill-, or submit-bound; call
+	//before init so the device features can be enabled
+	void setGpuCountersEnabled(bool enabled);
+
+	//External CPU profiler hooks, called with a zone name around each
+	//drawFrame stage (acquire, record, submit, present); the whole
+	//profiling surface compiles out of release builds
+	using ProfilerZoneCallback = void(*)(const char* zoneName);
+	void setProfilerCallbacks(ProfilerZoneCallback beginZone, ProfilerZoneCallback endZone);
+
+	//Adds a mesh to the packed vertex/index buffers;
+	//the GPU copies are rebuilt before the next frame
+	MeshHandle registerMesh(const std::vector<Vertex>& vertices,
+		const std::vector<uint32_t>& indices);
+
+	//Draw every registered mesh from a device-side indirect buffer
+	//instead of recording one vkCmdDrawIndexed per mesh
+	void setIndirectDrawEnabled(bool enabled);
+
+	//Compute: build a pipeline around a SPIR-V shader with one
+	//storage buffer at binding 0, then dispatch it on the compute queue
+	void setupCompute(const std::string& spvPath, VkDeviceSize storageBufferSize);
+	void dispatchCompute(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+
+	//Uploads into a destination buffer asynchronously on the transfer
+	//queue; the next frame's submit takes ownership before drawing
+	void streamBufferData(VkBuffer dstBuffer, const void* data,
+		VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+	//Replaces the bound texture with tightly packed RGBA8 pixels;
+	//the full mip chain is generated on the GPU
+	void createTexture(const void* pixels, uint32_t width, uint32_t height);
+
+	//Pipeline library: compiles the given variants in parallel on
+	//the worker pool (call during load screens)
+	void compilePipelineVariants(const std::vector<PipelineKey>& keys);
+
+	//Returns the cached pipeline for a variant; a miss kicks off an
+	//async compile and returns the base pipeline so frames never stall
+	VkPipeline getPipeline(const PipelineKey& key);
+
 private:
 
 	void createWindow();
@@ -136,23 +358,117 @@ private:
 	void createLogicalDevice();
 
 	void createSwapChain();
+	void createHeadlessTargets();
 	void createImageViews();
 
 	void recreateSwapChain();
 	void cleanupSwapChain();
+	void destroyRetiredSwapChains(bool force);
+
+	//Deferred destruction: hand live resources over instead of
+	//stalling the device before replacing them
+	void retireBuffer(VkBuffer buffer, const GpuAllocation& allocation);
+	void retireImage(VkImage image, VkImageView imageView, const GpuAllocation& allocation);
+	void destroyRetiredResources(bool force);
+
+	//Multi-surface: each extra window shares the device, pipelines,
+	//and scene but owns its swap chain and sync objects
+	struct WindowSurface;
+	void createExtraWindows();
+	void createExtraWindowSwapChain(WindowSurface& windowSurface);
+	void destroyExtraWindowSwapChain(WindowSurface& windowSurface);
+	void recreateExtraWindowSwapChain(WindowSurface& windowSurface);
+	void recordExtraWindowCommands(WindowSurface& windowSurface,
+		uint32_t imageIndex, uint32_t uniformIndex);
 
 	//Pipeline and renderer creation
 	void createRenderPass();
+	void createDepthResources();
+	VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates,
+		VkImageTiling tiling, VkFormatFeatureFlags features) const;
+	VkFormat findDepthFormat() const;
+	void createPipelineCache();
+	void savePipelineCache();
 	void createGraphicsPipeline();
+	VkPipeline buildGraphicsPipeline(const PipelineKey& key,
+		VkPipelineCache cache, VkPipeline basePipeline);
 	void createFramebuffers();
 	void createCommandPool();
+	void createWorkerCommandPools();
 	void createCommandBuffers();
 	void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+	void recordSecondaryCommandBuffer(VkCommandBuffer commandBuffer,
+		uint32_t imageIndex, uint32_t workerIndex);
 	void createSyncObjects();
-	void createVertexBuffer();
 
-	int getDeviceSuitability(VkPhysicalDevice device);
+	//Frame pacing governor
+	void paceFrame();
+	bool anyWindowFocused() const;
+
+	void buildMeshBuffers();
+	void buildIndirectBuffer();
+	uint32_t getRecordJobCount() const;
+
+	//GPU timestamp instrumentation
+	void createTimestampQueryPool();
+	double readGpuFrameTime(uint32_t imageIndex);
+
+	//GPU counter instrumentation
+	void createGpuCounterQueryPools();
+	void readGpuCounters(uint32_t imageIndex, FrameSample& sample);
+
+	//Debug-utils instrumentation: object names and command-buffer
+	//labels for RenderDoc/Nsight captures plus the CPU zone hooks
+	//(every body is empty in release builds)
+	void loadDebugUtilsFunctions();
+	void nameCoreObjects();
+	void setObjectName(uint64_t objectHandle, VkObjectType objectType, const char* name) const;
+	void beginCommandLabel(VkCommandBuffer commandBuffer, const char* labelName) const;
+	void endCommandLabel(VkCommandBuffer commandBuffer) const;
+	void profileZoneBegin(const char* zoneName) const;
+	void profileZoneEnd(const char* zoneName) const;
+
+	//Uniform buffer and descriptor creation
+	void createDescriptorSetLayout();
+	void createUniformBuffers();
+	void createDescriptorPool();
+	void createDescriptorSets();
+	void updateUniformBuffer(uint32_t imageIndex);
+
+	//Buffer/transfer helpers
+	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+		VkMemoryPropertyFlags properties,
+		VkBuffer& buffer, GpuAllocation& allocation);
+	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size,
+		VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+	void ensureStagingBuffer(VkDeviceSize size);
+
+	//Async streaming helpers
+	void createStreamingResources();
+	uint32_t acquireStreamingSlot(VkDeviceSize size);
+	void recordStreamingAcquires(VkCommandBuffer commandBuffer);
+
+	//Texture/image helpers
+	void createImage(uint32_t width, uint32_t height, uint32_t mipLevels,
+		VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
+		VkMemoryPropertyFlags properties,
+		VkImage& image, GpuAllocation& allocation);
+	VkImageView createImageView(VkImage image, VkFormat format, uint32_t mipLevels,
+		VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT);
+	void transitionImageLayout(VkImage image, VkImageLayout oldLayout,
+		VkImageLayout newLayout, uint32_t mipLevels);
+	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+	void generateMipmaps(VkImage image, VkFormat format,
+		int32_t width, int32_t height, uint32_t mipLevels);
+	void createTextureSampler();
+	void createDefaultTexture();
+	void destroyTexture();
+	VkCommandBuffer beginSingleTimeCommands();
+	void endSingleTimeCommands(VkCommandBuffer commandBuffer);
+
+	DeviceInfo scoreDevice(VkPhysicalDevice device, uint32_t index);
 	bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+	bool checkDynamicRenderingSupport(VkPhysicalDevice device) const;
 
 	//Swap chain supporting functions
 	QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) const;
@@ -211,21 +527,312 @@ private:
 	VkFormat mSwapChainImageFormat{};
 	VkExtent2D mSwapChainExtent{};
 
+	//Device-selection overrides applied by pickPhysicalDevice
+	std::optional<uint32_t> mPreferredDeviceIndex{};
+	std::optional<std::array<uint8_t, VK_UUID_SIZE>> mPreferredDeviceUuid{};
+	DeviceScoringCallback mDeviceScoringCallback{};
+
 	VkRenderPass mRenderPass{};
+	VkPipelineCache mPipelineCache{};
 	VkPipelineLayout mPipelineLayout{};
 	VkPipeline mGraphicsPipeline{};
 	VkCommandPool mCommandPool{};
-	std::vector<VkCommandBuffer> mCommandBuffers{};
 
-	//Sync objects
+	//Pipeline library: variants derived from the base pipeline,
+	//compiled on worker threads with their own caches
+	//(VK_NULL_HANDLE marks a compile still in flight)
+	std::map<PipelineKey, VkPipeline> mPipelineVariants{};
+	std::mutex mPipelineLibraryMutex{};
+
+	//One pre-recorded command buffer per swap-chain image,
+	//re-recorded only when its dirty flag is set
+	std::vector<VkCommandBuffer> mCommandBuffers{};
+	std::vector<bool> mCommandBufferDirty{};
+
+	//Per-thread command pools and the secondary command
+	//buffers recorded in parallel from them
+	//(indexed [imageIndex][workerIndex])
+	uint32_t mWorkerCount{};
+	std::vector<VkCommandPool> mWorkerCommandPools{};
+	std::vector<std::vector<VkCommandBuffer>> mSecondaryCommandBuffers{};
+	tf::Executor mExecutor{};
+
+	//Sync objects; acquisition is per frame in flight while
+	//render-finished signaling is per swap-chain image, since images
+	//can come back out of order relative to frames
 	std::vector<VkSemaphore> mImageAvailableSemaphore{};
 	std::vector<VkSemaphore> mRenderFinishedSemaphore{};
 	std::vector<VkFence> mInFlightFence{};
 
+	//The frame fence last submitted against each swap-chain image,
+	//so a frame never renders into an image still in flight
+	std::vector<VkFence> mImagesInFlight{};
+
 	bool mFramebufferResized{};
 
+	//Present policy: preferred mode, image margin over the surface
+	//minimum, and the optional late-latch wait
+	VkPresentModeKHR mPreferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+	uint32_t mSwapChainImageMargin = 1;
+	bool mLatencyWaitEnabled{};
+
+	//Frame pacing governor: the deadline chain keeps the cadence even
+	//when individual frames jitter, and the slack is how early the OS
+	//sleep hands over to the precise spin
+	double mTargetFrameSeconds{};
+	std::chrono::steady_clock::time_point mNextFrameDeadline{};
+	double mPacingSleepSlackSeconds = 0.002;
+	double mPacingWaitMs{};
+	bool mIdleWhenUnfocused{};
+	double mBackgroundFrameSeconds = 0.1;
+
+	//Dynamic rendering: render straight into the swap-chain image
+	//views with vkCmdBeginRendering, so resizes rebuild no render
+	//pass or framebuffer objects; mDynamicRenderingActive is the
+	//request ANDed with device support
+	bool mDynamicRenderingEnabled = true;
+	bool mDynamicRenderingActive{};
+	PFN_vkCmdBeginRenderingKHR mCmdBeginRenderingKHR{};
+	PFN_vkCmdEndRenderingKHR mCmdEndRenderingKHR{};
+
+	//Headless mode: mSwapChainImages holds offscreen targets backed
+	//by these allocations, so the per-image machinery runs unchanged
+	bool mHeadless{};
+	uint64_t mHeadlessFrameLimit{};
+	double mHeadlessDurationLimit{};
+	std::vector<GpuAllocation> mHeadlessImageAllocations{};
+
 	uint32_t mCurrentFrame{};
+	uint32_t mMaxFramesInFlight = DEFAULT_MAX_FRAMES_IN_FLIGHT;
 
-	VkBuffer mVertexBuffer{};
-	VkDeviceMemory mVertexBufferMemory{};
+	//Monotonic frame counter used to retire deferred destructions
+	uint64_t mFrameNumber{};
+
+	/// <summary>
+	/// A replaced swap chain kept alive until every frame
+	/// that could still reference it has finished
+	/// </summary>
+	struct RetiredSwapChain
+	{
+		VkSwapchainKHR swapChain{};
+		std::vector<VkImageView> imageViews{};
+		std::vector<VkFramebuffer> framebuffers{};
+		VkImage depthImage{};
+		VkImageView depthImageView{};
+		GpuAllocation depthImageAllocation{};
+		std::vector<VkSemaphore> renderFinishedSemaphores{};
+		uint64_t retireFrame{};
+	};
+
+	std::vector<RetiredSwapChain> mRetiredSwapChains{};
+
+	/// <summary>
+	/// Any GPU resource retired mid-run, destroyed once every frame
+	/// that could still reference it has signaled its fence; unset
+	/// handles are simply skipped
+	/// </summary>
+	struct RetiredResource
+	{
+		VkBuffer buffer{};
+		VkImage image{};
+		VkImageView imageView{};
+		GpuAllocation allocation{};
+		uint64_t retireFrame{};
+	};
+
+	std::vector<RetiredResource> mRetiredResources{};
+
+	/// <summary>
+	/// One extra window driven by the shared device: its swap chain,
+	/// attachments, sync objects, and per-frame command buffers
+	/// </summary>
+	struct WindowSurface
+	{
+		GLFWwindow* window{};
+		uint32_t width{};
+		uint32_t height{};
+		std::string title{};
+		VkSurfaceKHR surface{};
+		VkSwapchainKHR swapChain{};
+		VkExtent2D extent{};
+		std::vector<VkImage> images{};
+		std::vector<VkImageView> imageViews{};
+		std::vector<VkFramebuffer> framebuffers{};
+		VkImage depthImage{};
+		GpuAllocation depthImageAllocation{};
+		VkImageView depthImageView{};
+
+		//Acquisition is per frame in flight and render-finished
+		//signaling per image, mirroring the primary chain's sync layout
+		std::vector<VkSemaphore> imageAvailableSemaphores{};
+		std::vector<VkSemaphore> renderFinishedSemaphores{};
+		std::vector<VkFence> imagesInFlight{};
+
+		//Re-recorded every frame, so one buffer per frame in flight
+		std::vector<VkCommandBuffer> commandBuffers{};
+
+		//Image acquired for the frame being built
+		//(UINT32_MAX when the window sits this frame out)
+		uint32_t acquiredImage = UINT32_MAX;
+		bool resized{};
+	};
+
+	std::vector<WindowSurface> mExtraWindows{};
+
+	//Timestamp queries bracketing the render pass
+	//(two queries per swap-chain image)
+	VkQueryPool mTimestampQueryPool{};
+	float mTimestampPeriod{};
+	bool mTimestampsSupported{};
+
+	//GPU counter queries (one pipeline-statistics and one occlusion
+	//query per swap-chain image); mGpuCountersActive is the request
+	//ANDed with device support
+	bool mGpuCountersEnabled{};
+	bool mGpuCountersActive{};
+	VkQueryPool mPipelineStatsQueryPool{};
+	VkQueryPool mOcclusionQueryPool{};
+
+	//Debug-utils entry points (null when the extension is absent)
+	//and the external CPU profiler hooks
+#ifndef NDEBUG
+	PFN_vkSetDebugUtilsObjectNameEXT mSetDebugUtilsObjectNameEXT{};
+	PFN_vkCmdBeginDebugUtilsLabelEXT mCmdBeginDebugUtilsLabelEXT{};
+	PFN_vkCmdEndDebugUtilsLabelEXT mCmdEndDebugUtilsLabelEXT{};
+#endif
+	ProfilerZoneCallback mProfilerBeginZone{};
+	ProfilerZoneCallback mProfilerEndZone{};
+
+	FrameStats mFrameStats{};
+
+	//Packed buffers shared by every registered mesh, bound once per
+	//frame; vertices are split into a position stream and a shading
+	//attribute stream (see MeshVertexLayout)
+	VkBuffer mPositionBuffer{};
+	GpuAllocation mPositionBufferAllocation{};
+	VkBuffer mAttributeBuffer{};
+	GpuAllocation mAttributeBufferAllocation{};
+	VkBuffer mIndexBuffer{};
+	GpuAllocation mIndexBufferAllocation{};
+
+	//CPU-side mesh registry backing the packed buffers
+	std::vector<Vertex> mMeshVertices{};
+	std::vector<uint32_t> mMeshIndices{};
+	std::vector<MeshDraw> mMeshes{};
+	bool mMeshBuffersDirty{};
+
+	//Device-local VkDrawIndexedIndirectCommand array consumed
+	//by a single vkCmdDrawIndexedIndirect when enabled
+	VkBuffer mIndirectBuffer{};
+	GpuAllocation mIndirectBufferAllocation{};
+	bool mIndirectDrawEnabled{};
+	bool mMultiDrawIndirectSupported{};
+
+	//Compute subsystem; the queue comes from a dedicated compute
+	//family when the device has one
+	VkQueue mComputeQueue{};
+	VkCommandPool mComputeCommandPool{};
+	VkCommandBuffer mComputeCommandBuffer{};
+	VkDescriptorSetLayout mComputeDescriptorSetLayout{};
+	VkDescriptorPool mComputeDescriptorPool{};
+	VkDescriptorSet mComputeDescriptorSet{};
+	VkPipelineLayout mComputePipelineLayout{};
+	VkPipeline mComputePipeline{};
+	VkBuffer mComputeStorageBuffer{};
+	GpuAllocation mComputeStorageBufferAllocation{};
+	VkSemaphore mComputeFinishedSemaphore{};
+	VkFence mComputeFence{};
+	bool mComputePending{};
+	uint32_t mComputeFamilyIndex{};
+
+	/// <summary>
+	/// One slot of the streaming ring: a persistently mapped staging
+	/// buffer plus the command buffer, fence, and semaphore tracking
+	/// the async copy recorded from it
+	/// </summary>
+	struct StreamingSlot
+	{
+		VkBuffer stagingBuffer{};
+		GpuAllocation stagingAllocation{};
+		void* mapped{};
+		VkDeviceSize capacity{};
+		VkCommandBuffer commandBuffer{};
+		VkFence fence{};
+		VkSemaphore copyComplete{};
+		bool inFlight{};
+
+		//The graphics submit that waited on copyComplete, so the
+		//semaphore isn't re-signaled before that wait has retired
+		bool semaphorePending{};
+		uint64_t waitedAtFrame{};
+	};
+
+	/// <summary>
+	/// A buffer range written on another queue family (transfer upload
+	/// or compute dispatch) whose ownership still has to be acquired
+	/// on the graphics queue
+	/// </summary>
+	struct PendingAcquire
+	{
+		VkBuffer buffer{};
+		VkDeviceSize offset{};
+		VkDeviceSize size{};
+
+		//The family releasing ownership
+		uint32_t srcFamilyIndex{};
+	};
+
+	//Async streaming engine; the queue comes from a transfer-only
+	//family when the device has one
+	VkQueue mTransferQueue{};
+	VkCommandPool mTransferCommandPool{};
+	uint32_t mTransferFamilyIndex{};
+	uint32_t mGraphicsFamilyIndex{};
+	std::vector<StreamingSlot> mStreamingSlots{};
+	uint32_t mNextStreamingSlot{};
+	std::vector<PendingAcquire> mPendingAcquires{};
+
+	//Per-frame command buffers holding the ownership-acquire barriers,
+	//submitted ahead of the draw commands in the same batch
+	std::vector<VkCommandBuffer> mAcquireCommandBuffers{};
+
+	//Uniform buffer ring, persistently mapped at creation
+	//(one per swap-chain image to match the persistent command buffers)
+	VkDescriptorSetLayout mDescriptorSetLayout{};
+	VkDescriptorPool mDescriptorPool{};
+	std::vector<VkDescriptorSet> mDescriptorSets{};
+	std::vector<VkBuffer> mUniformBuffers{};
+	std::vector<GpuAllocation> mUniformBufferAllocations{};
+	std::vector<void*> mUniformBuffersMapped{};
+
+	//Depth attachment shared by every framebuffer, recreated
+	//alongside the swap chain
+	VkImage mDepthImage{};
+	GpuAllocation mDepthImageAllocation{};
+	VkImageView mDepthImageView{};
+	VkFormat mDepthFormat{};
+
+	//Sampled texture bound alongside the uniform buffer; stored with
+	//optimal tiling and a vkCmdBlitImage-generated mip chain
+	VkImage mTextureImage{};
+	GpuAllocation mTextureAllocation{};
+	VkImageView mTextureImageView{};
+	VkSampler mTextureSampler{};
+	uint32_t mTextureMipLevels{};
+
+	//Anisotropic filtering support picked up at device creation
+	bool mSamplerAnisotropySupported{};
+	float mMaxSamplerAnisotropy{};
+
+	//Reusable staging buffer for uploads to device-local memory
+	VkBuffer mStagingBuffer{};
+	GpuAllocation mStagingBufferAllocation{};
+	VkDeviceSize mStagingBufferSize{};
+
+	//Sub-allocates all buffer/image memory out of large slabs
+	GpuAllocator mAllocator{};
+
+	//Caches SPIR-V modules by content hash so pipeline rebuilds
+	//never re-read or re-create shaders
+	ShaderManager mShaderManager{};
 };
\ No newline at end of file
@@ -0,0 +1,446 @@
+#include "VulkanRenderer.h"
+
+#include <stdexcept>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+
+//Default workload sizes; every one can be overridden on the
+//command line so regression runs stay comparable over time
+constexpr uint64_t DEFAULT_WARMUP_FRAMES = 120;
+constexpr uint64_t DEFAULT_MEASURE_FRAMES = 1000;
+constexpr uint32_t DEFAULT_TRIANGLE_COUNT = 100000;
+constexpr uint32_t DEFAULT_DRAW_COUNT = 1000;
+constexpr uint32_t DEFAULT_PIPELINE_COUNT = 8;
+constexpr uint32_t DEFAULT_RESIZE_COUNT = 60;
+
+/// <summary>
+/// Everything the harness needs to know about one benchmark run,
+/// filled from the command line
+/// </summary>
+struct BenchmarkConfig
+{
+	uint64_t warmupFrames = DEFAULT_WARMUP_FRAMES;
+	uint64_t measureFrames = DEFAULT_MEASURE_FRAMES;
+	uint32_t triangleCount = DEFAULT_TRIANGLE_COUNT;
+	uint32_t drawCount = DEFAULT_DRAW_COUNT;
+	uint32_t pipelineCount = DEFAULT_PIPELINE_COUNT;
+	uint32_t resizeCount = DEFAULT_RESIZE_COUNT;
+
+	//Headless keeps measurements uncapped by any present mode; the
+	//resize scenario always runs windowed since it needs a swap chain
+	bool windowed{};
+
+	std::string jsonPath = "benchmark_results.json";
+	std::string csvPath = "benchmark_results.csv";
+
+	//Streams every individual frame sample when set
+	std::string frameCsvPath{};
+
+	//Empty runs every scenario
+	std::string scenario{};
+};
+
+/// <summary>
+/// Frame-time distribution of one scenario, pulled from the
+/// renderer's FrameStats after the measured frames
+/// </summary>
+struct BenchmarkResult
+{
+	std::string name{};
+	uint64_t frames{};
+	double averageMs{};
+	double p50Ms{};
+	double p90Ms{};
+	double p95Ms{};
+	double p99Ms{};
+	double averageGpuMs{};
+};
+
+/// <summary>
+/// Generates a soup of small random triangles spread across clip
+/// space, seeded so every run draws the identical scene
+/// </summary>
+/// <param name="triangleCount"></param>
+/// <param name="indices"></param>
+/// <returns></returns>
+static std::vector<Vertex> generateTriangleSoup(uint32_t triangleCount,
+	std::vector<uint32_t>& indices)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> position(-0.95f, 0.95f);
+	std::uniform_real_distribution<float> channel(0.0f, 1.0f);
+
+	std::vector<Vertex> vertices;
+	vertices.reserve((size_t)triangleCount * 3);
+	indices.reserve((size_t)triangleCount * 3);
+
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		float centerX = position(rng);
+		float centerY = position(rng);
+		glm::vec3 color = {channel(rng), channel(rng), channel(rng)};
+
+		vertices.push_back({{centerX - 0.02f, centerY + 0.02f}, color, {0.0f, 0.0f}});
+		vertices.push_back({{centerX + 0.02f, centerY + 0.02f}, color, {1.0f, 0.0f}});
+		vertices.push_back({{centerX, centerY - 0.02f}, color, {0.5f, 1.0f}});
+
+		indices.push_back(i * 3);
+		indices.push_back(i * 3 + 1);
+		indices.push_back(i * 3 + 2);
+	}
+
+	return vertices;
+}
+
+/// <summary>
+/// Render-state variants for the pipeline-switch scenario; only
+/// states every device supports without extra features
+/// </summary>
+/// <param name="count"></param>
+/// <returns></returns>
+static std::vector<PipelineKey> generatePipelineKeys(uint32_t count)
+{
+	const VkCullModeFlags cullModes[] = {
+		VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_FRONT_BIT, VK_CULL_MODE_NONE
+	};
+
+	std::vector<PipelineKey> keys;
+	keys.reserve(count);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		PipelineKey key{};
+		key.cullMode = cullModes[i % 3];
+		key.depthTest = (i & 1) != 0;
+		key.depthWrite = (i & 2) != 0;
+		keys.push_back(key);
+	}
+
+	return keys;
+}
+
+/// <summary>
+/// Runs warmup plus measured frames against an initialized renderer
+/// and snapshots its frame-time distribution
+/// </summary>
+/// <param name="renderer"></param>
+/// <param name="name"></param>
+/// <param name="config"></param>
+/// <param name="perFrame"></param>
+/// <returns></returns>
+static BenchmarkResult measureScenario(VulkanRenderer& renderer, const std::string& name,
+	const BenchmarkConfig& config, const std::function<void(uint64_t)>& perFrame)
+{
+	//Console reports would skew the numbers mid-run
+	renderer.getFrameStats().setReportInterval(0);
+
+	for (uint64_t frame = 0; frame < config.warmupFrames; frame++)
+	{
+		if (perFrame)
+		{
+			perFrame(frame);
+		}
+
+		renderer.drawFrame();
+	}
+
+	//Drop the warmup samples and size the window to the whole measured
+	//run, so the percentiles below cover exactly the frames reported
+	renderer.getFrameStats().reset((size_t)config.measureFrames);
+
+	if (!config.frameCsvPath.empty())
+	{
+		renderer.getFrameStats().enableCsvOutput(name + "_" + config.frameCsvPath);
+	}
+
+	for (uint64_t frame = config.warmupFrames;
+		frame < config.warmupFrames + config.measureFrames; frame++)
+	{
+		if (perFrame)
+		{
+			perFrame(frame);
+		}
+
+		renderer.drawFrame();
+	}
+
+	//Nothing may be in flight when the renderer is torn down
+	renderer.waitIdle();
+
+	const FrameStats& stats = renderer.getFrameStats();
+
+	BenchmarkResult result{};
+	result.name = name;
+	result.frames = config.measureFrames;
+	result.averageMs = stats.averageFrameMs();
+	result.p50Ms = stats.percentile(50.0);
+	result.p90Ms = stats.percentile(90.0);
+	result.p95Ms = stats.percentile(95.0);
+	result.p99Ms = stats.percentile(99.0);
+	result.averageGpuMs = stats.averageGpuMs();
+
+	std::cout << name << ": avg " << result.averageMs << " ms, p50 "
+		<< result.p50Ms << " ms, p99 " << result.p99Ms << " ms\n";
+
+	return result;
+}
+
+/// <summary>
+/// One mesh holding N triangles: measures raw vertex throughput
+/// </summary>
+/// <param name="config"></param>
+/// <returns></returns>
+static BenchmarkResult runTriangleScenario(const BenchmarkConfig& config)
+{
+	VulkanRenderer renderer{};
+	renderer.setHeadless(!config.windowed);
+	renderer.init();
+
+	std::vector<uint32_t> indices;
+	std::vector<Vertex> vertices = generateTriangleSoup(config.triangleCount, indices);
+	renderer.registerMesh(vertices, indices);
+
+	return measureScenario(renderer, "triangles", config, nullptr);
+}
+
+/// <summary>
+/// N single-triangle meshes: measures per-draw-call overhead in
+/// command recording and submission
+/// </summary>
+/// <param name="config"></param>
+/// <returns></returns>
+static BenchmarkResult runDrawCallScenario(const BenchmarkConfig& config)
+{
+	VulkanRenderer renderer{};
+	renderer.setHeadless(!config.windowed);
+	renderer.init();
+
+	std::vector<uint32_t> indices;
+	std::vector<Vertex> vertices = generateTriangleSoup(config.drawCount, indices);
+
+	//Register each triangle as its own mesh so recording emits one
+	//draw per triangle
+	std::vector<uint32_t> triangleIndices = {0, 1, 2};
+	for (uint32_t i = 0; i < config.drawCount; i++)
+	{
+		std::vector<Vertex> triangle(vertices.begin() + (size_t)i * 3,
+			vertices.begin() + (size_t)(i + 1) * 3);
+		renderer.registerMesh(triangle, triangleIndices);
+	}
+
+	return measureScenario(renderer, "draw_calls", config, nullptr);
+}
+
+/// <summary>
+/// Cycles through precompiled pipeline variants while forcing a
+/// re-record every frame: measures pipeline lookup plus command
+/// buffer recording under churn
+/// </summary>
+/// <param name="config"></param>
+/// <returns></returns>
+static BenchmarkResult runPipelineScenario(const BenchmarkConfig& config)
+{
+	VulkanRenderer renderer{};
+	renderer.setHeadless(!config.windowed);
+	renderer.init();
+
+	std::vector<uint32_t> indices;
+	std::vector<Vertex> vertices = generateTriangleSoup(config.triangleCount, indices);
+	renderer.registerMesh(vertices, indices);
+
+	std::vector<PipelineKey> keys = generatePipelineKeys(config.pipelineCount);
+	renderer.compilePipelineVariants(keys);
+
+	auto perFrame = [&](uint64_t frame)
+	{
+		renderer.getPipeline(keys[frame % keys.size()]);
+		renderer.markCommandBuffersDirty();
+	};
+
+	return measureScenario(renderer, "pipeline_switches", config, perFrame);
+}
+
+/// <summary>
+/// Forces a swap-chain rebuild every few frames: measures the
+/// deferred-destruction resize path; always windowed since headless
+/// runs have no swap chain to recreate
+/// </summary>
+/// <param name="config"></param>
+/// <returns></returns>
+static BenchmarkResult runResizeScenario(const BenchmarkConfig& config)
+{
+	VulkanRenderer renderer{};
+	renderer.init();
+
+	std::vector<uint32_t> indices;
+	std::vector<Vertex> vertices = generateTriangleSoup(config.triangleCount, indices);
+	renderer.registerMesh(vertices, indices);
+
+	//Spread the requested recreations evenly across the measured frames
+	uint64_t interval = std::max<uint64_t>(1,
+		config.measureFrames / std::max(1u, config.resizeCount));
+
+	auto perFrame = [&](uint64_t frame)
+	{
+		glfwPollEvents();
+
+		if (frame >= config.warmupFrames && frame % interval == 0)
+		{
+			renderer.requestSwapChainRecreate();
+		}
+	};
+
+	return measureScenario(renderer, "resize_storm", config, perFrame);
+}
+
+/// <summary>
+/// Writes every result as a JSON array for the regression tooling
+/// </summary>
+/// <param name="results"></param>
+/// <param name="path"></param>
+static void writeJson(const std::vector<BenchmarkResult>& results, const std::string& path)
+{
+	std::ofstream file(path);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("ERROR: Failed to open " + path + " for writing!\n");
+	}
+
+	file << "[\n";
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+
+		file << "  {\n"
+			<< "    \"scenario\": \"" << result.name << "\",\n"
+			<< "    \"frames\": " << result.frames << ",\n"
+			<< "    \"average_ms\": " << result.averageMs << ",\n"
+			<< "    \"p50_ms\": " << result.p50Ms << ",\n"
+			<< "    \"p90_ms\": " << result.p90Ms << ",\n"
+			<< "    \"p95_ms\": " << result.p95Ms << ",\n"
+			<< "    \"p99_ms\": " << result.p99Ms << ",\n"
+			<< "    \"average_gpu_ms\": " << result.averageGpuMs << "\n"
+			<< "  }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+
+	file << "]\n";
+}
+
+/// <summary>
+/// Writes one summary row per scenario for spreadsheet imports
+/// </summary>
+/// <param name="results"></param>
+/// <param name="path"></param>
+static void writeCsv(const std::vector<BenchmarkResult>& results, const std::string& path)
+{
+	std::ofstream file(path);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("ERROR: Failed to open " + path + " for writing!\n");
+	}
+
+	file << "scenario,frames,average_ms,p50_ms,p90_ms,p95_ms,p99_ms,average_gpu_ms\n";
+
+	for (const auto& result: results)
+	{
+		file << result.name << "," << result.frames << "," << result.averageMs << ","
+			<< result.p50Ms << "," << result.p90Ms << "," << result.p95Ms << ","
+			<< result.p99Ms << "," << result.averageGpuMs << "\n";
+	}
+}
+
+/// <summary>
+/// Parses "--flag value" style arguments into the config
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+static BenchmarkConfig parseArguments(int argc, char** argv)
+{
+	BenchmarkConfig config{};
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "--windowed")
+		{
+			config.windowed = true;
+		} else if (i + 1 < argc)
+		{
+			std::string value = argv[++i];
+
+			if (argument == "--warmup") config.warmupFrames = std::stoull(value);
+			else if (argument == "--frames") config.measureFrames = std::stoull(value);
+			else if (argument == "--triangles") config.triangleCount = (uint32_t)std::stoul(value);
+			else if (argument == "--draws") config.drawCount = (uint32_t)std::stoul(value);
+			else if (argument == "--pipelines") config.pipelineCount = (uint32_t)std::stoul(value);
+			else if (argument == "--resizes") config.resizeCount = (uint32_t)std::stoul(value);
+			else if (argument == "--json") config.jsonPath = value;
+			else if (argument == "--csv") config.csvPath = value;
+			else if (argument == "--frame-csv") config.frameCsvPath = value;
+			else if (argument == "--scenario") config.scenario = value;
+			else throw std::runtime_error("ERROR: Unknown argument " + argument + "!\n");
+		} else
+		{
+			throw std::runtime_error("ERROR: Missing value for " + argument + "!\n");
+		}
+	}
+
+	return config;
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		BenchmarkConfig config = parseArguments(argc, argv);
+
+		std::vector<BenchmarkResult> results;
+
+		if (config.scenario.empty() || config.scenario == "triangles")
+		{
+			results.push_back(runTriangleScenario(config));
+		}
+
+		if (config.scenario.empty() || config.scenario == "draw_calls")
+		{
+			results.push_back(runDrawCallScenario(config));
+		}
+
+		if (config.scenario.empty() || config.scenario == "pipeline_switches")
+		{
+			results.push_back(runPipelineScenario(config));
+		}
+
+		if (config.scenario.empty() || config.scenario == "resize_storm")
+		{
+			results.push_back(runResizeScenario(config));
+		}
+
+		if (!config.jsonPath.empty())
+		{
+			writeJson(results, config.jsonPath);
+		}
+
+		if (!config.csvPath.empty())
+		{
+			writeCsv(results, config.csvPath);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}